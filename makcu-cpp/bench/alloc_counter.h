@@ -0,0 +1,48 @@
+#pragma once
+
+// Counts every operator new in the process (all threads). Include from
+// exactly one translation unit of a benchmark: it replaces the global
+// allocation functions.
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace bench {
+
+    inline std::atomic<uint64_t> g_allocations{ 0 };
+
+    inline uint64_t allocations() {
+        return g_allocations.load(std::memory_order_relaxed);
+    }
+
+}
+
+void* operator new(std::size_t size) {
+    bench::g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* block = std::malloc(size ? size : 1)) {
+        return block;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* block) noexcept {
+    std::free(block);
+}
+
+void operator delete[](void* block) noexcept {
+    std::free(block);
+}
+
+void operator delete(void* block, std::size_t) noexcept {
+    std::free(block);
+}
+
+void operator delete[](void* block, std::size_t) noexcept {
+    std::free(block);
+}
@@ -0,0 +1,60 @@
+// Heap allocations per move/wheel command, counted across every thread
+// (caller, writer, listener and the fake device), inline and with the
+// writer thread. The hot paths should report 0.000.
+//
+// Build: bench/build_benchmarks.sh
+
+#include "../include/makcu.h"
+#include "alloc_counter.h"
+#include "fake_device.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+    template<typename Fn>
+    void measure(const char* mode, const char* label, Fn command) {
+        const int calls = 20000;
+        command(0);  // Warm up thread-local buffers
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        uint64_t before = bench::allocations();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 1; i <= calls; ++i) {
+            command(i);
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / calls;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));  // Let the writer drain
+        uint64_t allocated = bench::allocations() - before;
+
+        std::cout << "  " << std::left << std::setw(7) << mode << std::setw(7) << label << std::right
+            << std::fixed << std::setprecision(0) << std::setw(7) << ns << " ns/call  "
+            << std::setprecision(3) << static_cast<double>(allocated) / calls << " allocs/call\n";
+    }
+
+}
+
+int main() {
+    std::cout << "=== ALLOCATIONS PER COMMAND ===\n";
+
+    FakeDevice fake;
+    makcu::Device device;
+    if (!fake.isValid() || !device.connect(fake.name())) {
+        std::cout << "Failed to connect to the fake device\n";
+        return 1;
+    }
+
+    for (bool writer : { false, true }) {
+        device.enableWriterThread(writer);
+        const char* mode = writer ? "writer" : "inline";
+        measure(mode, "move", [&](int i) { device.mouseMove(i % 7 - 3, -(i % 5)); });
+        measure(mode, "wheel", [&](int i) { device.mouseWheel(i & 1 ? 1 : -1); });
+        measure(mode, "smooth", [&](int i) { device.mouseMoveSmooth(i % 200 - 100, -i % 90, 8); });
+        measure(mode, "bezier", [&](int i) { device.mouseMoveBezier(i % 200 - 100, 1234567, 16, -i, 42); });
+    }
+
+    device.disconnect();
+    return 0;
+}
@@ -0,0 +1,83 @@
+// *Async Device calls against the std::async-per-call pattern they
+// replaced: fire-and-forget moves and clicks (enqueued directly, no thread
+// hop) and version queries (persistent executor). Each case issues a batch
+// of calls, then waits for every future; reports caller ns per call and
+// ns per call until all results were in.
+//
+// Build: bench/build_benchmarks.sh
+
+#include "../include/makcu.h"
+#include "fake_device.h"
+#include <chrono>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    template<typename T>
+    void measure(const char* label, int calls, const std::function<std::future<T>()>& call) {
+        std::vector<std::future<T>> futures;
+        futures.reserve(calls);
+        for (int i = 0; i < 20; ++i) {
+            call().get();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        auto start = Clock::now();
+        for (int i = 0; i < calls; ++i) {
+            futures.push_back(call());
+        }
+        double callerNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / calls;
+        for (auto& future : futures) {
+            future.get();
+        }
+        double totalNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / calls;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        std::cout << std::left << std::setw(30) << label << std::right << std::fixed << std::setprecision(0)
+            << std::setw(10) << callerNs << std::setw(12) << totalNs << "\n";
+    }
+
+}
+
+int main() {
+    std::cout << "=== ASYNC CALLS: EXECUTOR VS std::async ===\n";
+
+    FakeDevice fake;
+    makcu::Device device;
+    if (!fake.isValid() || !device.connect(fake.name())) {
+        std::cout << "Failed to connect to the fake device\n";
+        return 1;
+    }
+
+    const int commands = 2000;
+    const int queries = 500;
+    std::cout << "case                          caller ns  complete ns\n";
+    measure<bool>("mouseMoveAsync", commands, [&] {
+        return device.mouseMoveAsync(1, -1);
+        });
+    measure<bool>("std::async(mouseMove)", commands, [&] {
+        return std::async(std::launch::async, [&] { return device.mouseMove(1, -1); });
+        });
+    measure<bool>("clickAsync", commands, [&] {
+        return device.clickAsync(makcu::MouseButton::LEFT);
+        });
+    measure<bool>("std::async(click)", commands, [&] {
+        return std::async(std::launch::async, [&] { return device.click(makcu::MouseButton::LEFT); });
+        });
+    measure<std::string>("getVersionAsync", queries, [&] {
+        return device.getVersionAsync();
+        });
+    measure<std::string>("std::async(getVersion)", queries, [&] {
+        return std::async(std::launch::async, [&] { return device.getVersion(); });
+        });
+
+    device.disconnect();
+    return 0;
+}
@@ -0,0 +1,95 @@
+// BatchCommandBuilder cost per frame for batch sizes 1 to 64: one reused
+// builder is reset, refilled and executed every frame. Reports time,
+// heap allocations, write() calls and bytes per frame.
+//
+// Build: bench/build_benchmarks.sh
+
+#include "../include/makcu.h"
+#include "alloc_counter.h"
+#include "fake_device.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+
+// Count write() calls made by the library; the fake device only writes
+// when it answers a query, which a batch never sends
+namespace bench {
+    inline std::atomic<uint64_t> g_writes{ 0 };
+}
+
+extern "C" ssize_t write(int fd, const void* data, size_t length) {
+    bench::g_writes.fetch_add(1, std::memory_order_relaxed);
+    return static_cast<ssize_t>(::syscall(SYS_write, fd, data, length));
+}
+#endif
+
+namespace {
+
+    uint64_t writes() {
+#if defined(__linux__)
+        return bench::g_writes.load(std::memory_order_relaxed);
+#else
+        return 0;
+#endif
+    }
+
+}
+
+int main() {
+    std::cout << "=== BATCH EXECUTION ===\n";
+
+    FakeDevice fake;
+    makcu::Device device;
+    if (!fake.isValid() || !device.connect(fake.name())) {
+        std::cout << "Failed to connect to the fake device\n";
+        return 1;
+    }
+
+    std::cout << "size  ns/frame  allocs/frame  writes/frame  bytes/frame\n";
+    const int frames = 3000;
+    const int warmup = 50;
+    auto batch = device.createBatch();
+    for (int size : { 1, 2, 4, 8, 9, 16, 32, 64 }) {
+        uint64_t allocations = 0;
+        uint64_t writeCalls = 0;
+        uint64_t bytes = 0;
+        auto start = std::chrono::steady_clock::now();
+
+        for (int frame = -warmup; frame < frames; ++frame) {
+            if (frame == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                allocations = bench::allocations();
+                writeCalls = writes();
+                bytes = fake.bytesReceived();
+                start = std::chrono::steady_clock::now();
+            }
+
+            // A mix of every command kind
+            batch.reset();
+            for (int i = 0; i < size; ++i) {
+                switch (i % 4) {
+                case 0: batch.move(i - 3, frame % 5); break;
+                case 1: batch.press(makcu::MouseButton::LEFT); break;
+                case 2: batch.release(makcu::MouseButton::LEFT); break;
+                default: batch.scroll(1); break;
+                }
+            }
+            batch.execute();
+        }
+
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / frames;
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        std::cout << std::setw(4) << size << std::fixed << std::setprecision(0) << std::setw(10) << ns
+            << std::setprecision(2)
+            << std::setw(14) << static_cast<double>(bench::allocations() - allocations) / frames
+            << std::setw(14) << static_cast<double>(writes() - writeCalls) / frames
+            << std::setprecision(1) << std::setw(13) << static_cast<double>(fake.bytesReceived() - bytes) / frames << "\n";
+    }
+
+    device.disconnect();
+    return 0;
+}
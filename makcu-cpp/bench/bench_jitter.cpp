@@ -0,0 +1,102 @@
+// Button event latency with and without SerialPort real-time mode: the fake
+// device writes a mask byte every 200 us and the listener's callback
+// records how long it took to arrive. Optional CPU hogs add contention.
+//
+// Build: bench/build_benchmarks.sh
+// Run as root (or with CAP_SYS_NICE / CAP_IPC_LOCK) for SCHED_FIFO and mlockall
+
+#include "../include/serialport.h"
+#include "fake_device.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void run(bool realtime, int hogs) {
+        const int events = 20000;
+
+        FakeDevice device;
+        makcu::SerialPort port;
+        if (!device.isValid() || !port.open(device.name(), 4000000)) {
+            std::cout << "Failed to open the fake device\n";
+            return;
+        }
+
+        makcu::RealtimeConfig config;
+        config.enabled = realtime;
+        config.listenerCpu = 0;
+        config.writerCpu = 0;
+        bool applied = port.setRealtimeMode(config);
+
+        std::atomic<int64_t> sentAt{ 0 };
+        std::vector<int64_t> latencies;
+        latencies.reserve(events);
+        port.setButtonCallback([&](uint8_t, bool) {
+            latencies.push_back(nowNs() - sentAt.load());
+            });
+
+        std::atomic<bool> stop{ false };
+        std::vector<std::thread> load;
+        for (int i = 0; i < hogs; ++i) {
+            load.emplace_back([&] {
+                volatile uint64_t sink = 0;
+                while (!stop) {
+                    for (int k = 0; k < 1000; ++k) {
+                        sink = sink + k;
+                    }
+                }
+                });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        makcu::RealtimeStatus status = port.getRealtimeStatus();
+
+        // Alternate LEFT down / all up so every byte is an event
+        for (int i = 0; i < events; ++i) {
+            uint8_t mask = (i & 1) ? 0x00 : 0x01;
+            sentAt = nowNs();
+            device.send(&mask, 1);
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        stop = true;
+        for (auto& thread : load) {
+            thread.join();
+        }
+        port.close();
+
+        std::vector<int64_t> sorted = latencies;
+        std::sort(sorted.begin(), sorted.end());
+        auto percentile = [&](double p) {
+            return sorted.empty() ? 0.0 : sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()))] / 1000.0;
+        };
+        std::cout << std::left << std::setw(8) << (realtime ? "realtime" : "default") << std::right
+            << " load=" << hogs << " events=" << sorted.size() << std::fixed << std::setprecision(1)
+            << "  p50 " << std::setw(7) << percentile(0.5) << " us"
+            << "  p99 " << std::setw(8) << percentile(0.99) << " us"
+            << "  p999 " << std::setw(8) << percentile(0.999) << " us"
+            << "  max " << std::setw(8) << (sorted.empty() ? 0.0 : sorted.back() / 1000.0) << " us"
+            << "  [applied=" << applied << " affinity=" << status.affinity << " priority=" << status.priority
+            << " mlock=" << status.memoryLocked << " lowlat=" << status.lowLatencyTty << "]\n";
+    }
+
+}
+
+int main() {
+    std::cout << "=== BUTTON EVENT LATENCY ===\n";
+    for (int hogs : { 0, 2 }) {
+        run(false, hogs);
+        run(true, hogs);
+    }
+    return 0;
+}
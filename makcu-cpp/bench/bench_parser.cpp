@@ -0,0 +1,90 @@
+// Receive parser throughput: replays listener-style traffic through
+// SerialPort::feedReceived() and reports lines/sec. Built twice, with the
+// library's SIMD control-byte scan and with -DMAKCU_NO_SIMD; both builds
+// must print the same event hash.
+//
+// Build: bench/build_benchmarks.sh
+
+#include "../include/serialport.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace {
+
+    // Traffic shaped like a monitored 4 Mbaud session: km.* echoes behind
+    // the ">>> " prompt, id-correlated replies, an occasional multi-line
+    // version reply and, with buttons on, mask bytes between lines
+    std::string makeTraffic(bool buttons) {
+        std::string traffic;
+        for (int i = 0; i < 2000; ++i) {
+            traffic += ">>> km.move(" + std::to_string(i % 7) + "," + std::to_string(-(i % 5)) + ")\r\n";
+            if (buttons || i % 4 == 0) {
+                traffic.push_back(static_cast<char>(i % 3));
+            }
+            traffic += ">>> km.catch_ml()#" + std::to_string(100 + i) + ":" + std::to_string(i % 3) + "\r\n";
+            if (buttons) {
+                int mask = (i * 7) % 31;
+                traffic.push_back(static_cast<char>(mask == 0x0A || mask == 0x0D ? 1 : mask));
+            }
+            if (i % 10 == 0) {
+                traffic += ">>> km.version()\r\nkm.MAKCU v3.2 build 2025-01-01 USB-Enhanced-SERIAL CH343\r\n";
+            }
+        }
+        return traffic;
+    }
+
+    void run(const char* label, bool buttons) {
+        const std::string traffic = makeTraffic(buttons);
+        const size_t lines = static_cast<size_t>(std::count(traffic.begin(), traffic.end(), '\n'));
+        const size_t chunk = 4096;  // One listener read
+        const int repetitions = 30;
+
+        makcu::SerialPort port;
+        uint64_t events = 0;
+        uint64_t hash = 1469598103934665603ull;  // FNV-1a over the event order
+        port.setButtonCallback([&](uint8_t button, bool pressed) {
+            hash = (hash ^ (button * 2u + (pressed ? 1u : 0u))) * 1099511628211ull;
+            ++events;
+            });
+
+        double best = 1e9;
+        for (int rep = 0; rep < repetitions; ++rep) {
+            auto start = std::chrono::steady_clock::now();
+            for (size_t offset = 0; offset < traffic.size(); offset += chunk) {
+                port.feedReceived(reinterpret_cast<const uint8_t*>(traffic.data()) + offset,
+                    std::min(chunk, traffic.size() - offset));
+            }
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        makcu::ReceiveStats stats = port.getReceiveStats();
+        std::cout << std::left << std::setw(8) << label << std::right << std::fixed
+            << std::setw(6) << lines << " lines " << std::setw(7) << traffic.size() << " bytes: "
+            << std::setprecision(2) << std::setw(7) << lines / best / 1e6 << " M lines/s "
+            << std::setprecision(0) << std::setw(6) << traffic.size() / best / 1e6 << " MB/s"
+            << "  per pass: zero-copy " << stats.linesZeroCopy / repetitions
+            << " assembled " << stats.linesAssembled / repetitions
+            << " events " << events / repetitions
+            << " hash " << std::hex << hash << std::dec << "\n";
+    }
+
+}
+
+int main() {
+#if defined(MAKCU_NO_SIMD)
+    std::cout << "=== RECEIVE PARSER (scalar scan) ===\n";
+#elif defined(__AVX2__)
+    std::cout << "=== RECEIVE PARSER (AVX2 scan) ===\n";
+#elif defined(__SSE2__) || defined(_M_X64)
+    std::cout << "=== RECEIVE PARSER (SSE2 scan) ===\n";
+#else
+    std::cout << "=== RECEIVE PARSER (scalar scan) ===\n";
+#endif
+    run("echo", false);
+    run("buttons", true);
+    return 0;
+}
@@ -0,0 +1,92 @@
+// Enqueue-to-write delay per command class while the writer is flooded:
+// two threads push QUERY-class lines and uncoalesced moves as fast as the
+// queue takes them, while the main thread presses/releases a button every
+// 500 us. Reports the writer's per-class delay counters with priority
+// classes off (one FIFO) and on; max covers the warm-up too.
+//
+// Build: bench/build_benchmarks.sh
+
+#include "../include/serialport.h"
+#include "fake_device.h"
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    const char* className(size_t index) {
+        switch (static_cast<makcu::CommandPriority>(index)) {
+        case makcu::CommandPriority::CONTROL: return "CONTROL";
+        case makcu::CommandPriority::MOTION: return "MOTION";
+        default: return "QUERY";
+        }
+    }
+
+    void run(bool classes) {
+        const int clicks = 2000;
+
+        FakeDevice device;
+        makcu::SerialPort port;
+        if (!device.isValid() || !port.open(device.name(), 4000000)) {
+            std::cout << "Failed to open the fake device\n";
+            return;
+        }
+        port.setCoalescingEnabled(false);
+        port.setWriterThreadEnabled(true);
+        port.setPriorityClassesEnabled(classes);
+
+        std::atomic<bool> stop{ false };
+        std::vector<std::thread> flood;
+        flood.emplace_back([&] {
+            const char line[] = "km.info()                                               \r\n";
+            while (!stop) {
+                port.sendEncoded(line, sizeof(line) - 1, makcu::CommandPriority::QUERY);
+            }
+            });
+        flood.emplace_back([&] {
+            while (!stop) {
+                port.sendMove(1, -1);
+            }
+            });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        makcu::WriterStats before = port.getWriterStats();
+        for (int i = 0; i < clicks; ++i) {
+            port.sendButton(makcu::MouseButton::LEFT, (i & 1) == 0);
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+        makcu::WriterStats after = port.getWriterStats();
+
+        stop = true;
+        for (auto& thread : flood) {
+            thread.join();
+        }
+        port.close();
+
+        std::cout << (classes ? "classes on\n" : "classes off (single FIFO)\n");
+        for (size_t index = 0; index < makcu::COMMAND_PRIORITY_COUNT; ++index) {
+            const auto& now = after.classes[index];
+            const auto& then = before.classes[index];
+            uint64_t commands = now.commands - then.commands;
+            double averageUs = commands ? (now.totalDelayNs - then.totalDelayNs) / 1000.0 / commands : 0.0;
+            std::cout << "  " << std::left << std::setw(8) << className(index) << std::right
+                << std::setw(10) << commands << " cmds" << std::fixed << std::setprecision(1)
+                << "  avg " << std::setw(8) << averageUs << " us"
+                << "  max " << std::setw(9) << now.maxDelayNs / 1000.0 << " us"
+                << "  promotions " << now.promotions - then.promotions << "\n";
+        }
+        std::cout << "  writes " << after.writeSyscalls - before.writeSyscalls
+            << "  queue-full waits " << after.queueFullWaits - before.queueFullWaits << "\n";
+    }
+
+}
+
+int main() {
+    std::cout << "=== PRIORITY CLASS DELAY ===\n";
+    run(false);
+    run(true);
+    return 0;
+}
@@ -0,0 +1,163 @@
+// Prepared sequences against the direct calls they replace: 9 zero-delay
+// moves and 3 clicks, each through movePattern/clickSequence, replay(),
+// replayAsync() and both replays with a scale/offset transform. Reports
+// ns, write() calls and wire bytes per step. replayAsync() is timed at
+// the caller and again until the action completed; write() counts
+// include the timer thread's wake-up.
+//
+// Build: bench/build_benchmarks.sh
+
+#include "../include/makcu.h"
+#include "fake_device.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+
+// Count write() calls made by the library; the fake device only writes
+// when it answers a query, which none of these cases send
+namespace bench {
+    inline std::atomic<uint64_t> g_writes{ 0 };
+}
+
+extern "C" ssize_t write(int fd, const void* data, size_t length) {
+    bench::g_writes.fetch_add(1, std::memory_order_relaxed);
+    return static_cast<ssize_t>(::syscall(SYS_write, fd, data, length));
+}
+#endif
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    uint64_t writes() {
+#if defined(__linux__)
+        return bench::g_writes.load(std::memory_order_relaxed);
+#else
+        return 0;
+#endif
+    }
+
+    // Runs body `runs` times after a warm-up, in blocks; body returns the
+    // time to charge for one run (the caller-visible part for async cases).
+    // ns is the best block: pty write latency alone swings a 9-write run
+    // between ~11 and ~24 us from one block to the next
+    void measure(const char* label, FakeDevice& fake, size_t steps, const std::function<double()>& body) {
+        const int runs = 2000;
+        const int blocks = 5;
+        for (int i = 0; i < 50; ++i) {
+            body();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        uint64_t writeCalls = writes();
+        uint64_t bytes = fake.bytesReceived();
+        double best = 0;
+        for (int block = 0; block < blocks; ++block) {
+            double ns = 0;
+            for (int i = 0; i < runs / blocks; ++i) {
+                ns += body();
+            }
+            best = block == 0 ? ns : std::min(best, ns);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        double perStep = static_cast<double>(runs * steps);
+        std::cout << std::left << std::setw(34) << label << std::right << std::fixed
+            << std::setprecision(0) << std::setw(9) << best * blocks / perStep
+            << std::setprecision(2) << std::setw(13) << static_cast<double>(writes() - writeCalls) / perStep
+            << std::setprecision(1) << std::setw(13) << static_cast<double>(fake.bytesReceived() - bytes) / perStep << "\n";
+    }
+
+    template<typename F>
+    double timed(F&& f) {
+        auto start = Clock::now();
+        f();
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+
+}
+
+int main() {
+    std::cout << "=== PREPARED SEQUENCE REPLAY ===\n";
+
+    FakeDevice fake;
+    makcu::Device device;
+    if (!fake.isValid() || !device.connect(fake.name())) {
+        std::cout << "Failed to connect to the fake device\n";
+        return 1;
+    }
+
+    std::vector<std::pair<int32_t, int32_t>> points;
+    std::vector<makcu::SequenceStep> moveSteps;
+    for (int i = 0; i < 9; ++i) {
+        points.emplace_back(i - 4, 4 - i);
+        moveSteps.push_back(makcu::SequenceStep::move(i - 4, 4 - i));
+    }
+    const std::vector<makcu::MouseButton> buttons = {
+        makcu::MouseButton::LEFT, makcu::MouseButton::RIGHT, makcu::MouseButton::MIDDLE
+    };
+    std::vector<makcu::SequenceStep> clickSteps;
+    for (auto button : buttons) {
+        clickSteps.push_back(makcu::SequenceStep::press(button));
+        clickSteps.push_back(makcu::SequenceStep::release(button));
+    }
+
+    makcu::PreparedSequence moves = device.prepare(moveSteps);
+    makcu::PreparedSequence clicks = device.prepare(clickSteps);
+    makcu::ReplayTransform transform;
+    transform.scaleX = 1.5;
+    transform.scaleY = 0.75;
+    transform.offsetX = 1;
+    transform.offsetY = -1;
+
+    std::cout << "case                                ns/step  writes/step   bytes/step\n";
+    measure("movePattern(smooth=false)", fake, moveSteps.size(), [&] {
+        return timed([&] { device.movePattern(points, false); });
+        });
+    measure("replay, 9 moves", fake, moveSteps.size(), [&] {
+        return timed([&] { device.replay(moves); });
+        });
+    measure("replay, 9 moves, transformed", fake, moveSteps.size(), [&] {
+        return timed([&] { device.replay(moves, transform); });
+        });
+    makcu::ScheduledAction action;
+    measure("replayAsync, 9 moves (caller)", fake, moveSteps.size(), [&] {
+        double ns = timed([&] { action = device.replayAsync(moves); });
+        action.wait();
+        return ns;
+        });
+    measure("replayAsync, 9 moves (complete)", fake, moveSteps.size(), [&] {
+        return timed([&] { device.replayAsync(moves).wait(); });
+        });
+    measure("replayAsync, transformed (caller)", fake, moveSteps.size(), [&] {
+        double ns = timed([&] { action = device.replayAsync(moves, transform); });
+        action.wait();
+        return ns;
+        });
+
+    measure("clickSequence(delay 0)", fake, clickSteps.size(), [&] {
+        return timed([&] { device.clickSequence(buttons, std::chrono::milliseconds(0)); });
+        });
+    measure("replay, 3 clicks", fake, clickSteps.size(), [&] {
+        return timed([&] { device.replay(clicks); });
+        });
+    measure("replayAsync, 3 clicks (caller)", fake, clickSteps.size(), [&] {
+        double ns = timed([&] { action = device.replayAsync(clicks); });
+        action.wait();
+        return ns;
+        });
+    measure("replayAsync, 3 clicks (complete)", fake, clickSteps.size(), [&] {
+        return timed([&] { device.replayAsync(clicks).wait(); });
+        });
+
+    device.disconnect();
+    return 0;
+}
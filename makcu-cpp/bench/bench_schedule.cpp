@@ -0,0 +1,153 @@
+// Timer-scheduler accuracy: 5000 moves scheduled 1 ms apart, each compared
+// with the moment its write() reached the pty (interposed below), against
+// a caller thread that sleep_until()s each deadline and writes itself.
+// The scheduler is also run in real-time mode and its own ScheduleStats
+// (deadline to submit) are printed next to the measured lateness.
+//
+// Build: bench/build_benchmarks.sh
+// Run as root (or with CAP_SYS_NICE) for SCHED_FIFO
+
+#include "../include/serialport.h"
+#include "fake_device.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+
+// Timestamp every command write; 8-byte writes are eventfd wakeups
+namespace bench {
+    constexpr size_t MAX_WRITES = 1 << 16;
+    inline std::atomic<size_t> g_writeCount{ 0 };
+    inline int64_t g_writeTimes[MAX_WRITES];
+}
+
+extern "C" ssize_t write(int fd, const void* data, size_t length) {
+    if (length != 8) {
+        size_t index = bench::g_writeCount.fetch_add(1, std::memory_order_relaxed);
+        if (index < bench::MAX_WRITES) {
+            bench::g_writeTimes[index] = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+    }
+    return static_cast<ssize_t>(::syscall(SYS_write, fd, data, length));
+}
+#endif
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    const int COMMANDS = 5000;
+    const auto PERIOD = std::chrono::milliseconds(1);
+
+    void report(const char* label, const std::vector<Clock::time_point>& deadlines, size_t firstWrite,
+        const makcu::ScheduleStats* stats) {
+#if defined(__linux__)
+        std::vector<double> lateness;
+        size_t writes = std::min(bench::g_writeCount.load() - firstWrite, deadlines.size());
+        for (size_t i = 0; i < writes; ++i) {
+            int64_t deadline = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                deadlines[i].time_since_epoch()).count();
+            lateness.push_back((bench::g_writeTimes[firstWrite + i] - deadline) / 1000.0);
+        }
+        std::sort(lateness.begin(), lateness.end());
+        auto percentile = [&](double p) {
+            return lateness.empty() ? 0.0 : lateness[std::min(lateness.size() - 1, static_cast<size_t>(p * lateness.size()))];
+        };
+        std::cout << std::left << std::setw(20) << label << std::right << std::fixed << std::setprecision(1)
+            << " writes " << std::setw(5) << lateness.size()
+            << "  p50 " << std::setw(7) << percentile(0.5) << " us"
+            << "  p99 " << std::setw(7) << percentile(0.99) << " us"
+            << "  p999 " << std::setw(7) << percentile(0.999) << " us"
+            << "  max " << std::setw(8) << (lateness.empty() ? 0.0 : lateness.back()) << " us";
+#else
+        (void)deadlines;
+        (void)firstWrite;
+        std::cout << std::left << std::setw(20) << label << std::right << std::fixed << std::setprecision(1);
+#endif
+        if (stats && stats->fired) {
+            std::cout << "  [stats avg " << stats->averageLatenessUs() << " us, max "
+                << stats->maxLatenessNs / 1000.0 << " us]";
+        }
+        std::cout << "\n";
+    }
+
+    size_t writeCount() {
+#if defined(__linux__)
+        return bench::g_writeCount.load();
+#else
+        return 0;
+#endif
+    }
+
+    void runScheduled(bool realtime) {
+        FakeDevice device;
+        makcu::SerialPort port;
+        if (!device.isValid() || !port.open(device.name(), 4000000)) {
+            std::cout << "Failed to open the fake device\n";
+            return;
+        }
+        makcu::RealtimeConfig config;
+        config.enabled = realtime;
+        config.writerCpu = 0;
+        port.setRealtimeMode(config);
+
+        // Warm the scheduler thread up
+        port.schedule({ { Clock::now(), "km.move(0,0)" } }).wait();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        std::vector<Clock::time_point> deadlines;
+        std::vector<makcu::SerialPort::ScheduleStep> steps;
+        auto start = Clock::now() + std::chrono::milliseconds(20);
+        for (int i = 0; i < COMMANDS; ++i) {
+            deadlines.push_back(start + i * PERIOD);
+            steps.emplace_back(deadlines.back(), "km.move(1,0)");
+        }
+        makcu::ScheduleStats before = port.getScheduleStats();
+        size_t firstWrite = writeCount();
+        port.schedule(steps).wait();
+        makcu::ScheduleStats after = port.getScheduleStats();
+        port.close();
+
+        makcu::ScheduleStats stats;
+        stats.fired = after.fired - before.fired;
+        stats.totalLatenessNs = after.totalLatenessNs - before.totalLatenessNs;
+        stats.maxLatenessNs = after.maxLatenessNs;
+        report(realtime ? "scheduled, realtime" : "scheduled", deadlines, firstWrite, &stats);
+    }
+
+    void runSleeping() {
+        FakeDevice device;
+        makcu::SerialPort port;
+        if (!device.isValid() || !port.open(device.name(), 4000000)) {
+            std::cout << "Failed to open the fake device\n";
+            return;
+        }
+
+        std::vector<Clock::time_point> deadlines;
+        auto start = Clock::now() + std::chrono::milliseconds(20);
+        size_t firstWrite = writeCount();
+        for (int i = 0; i < COMMANDS; ++i) {
+            deadlines.push_back(start + i * PERIOD);
+            std::this_thread::sleep_until(deadlines.back());
+            port.sendCommand("km.move(1,0)");
+        }
+        port.close();
+        report("caller sleep_until", deadlines, firstWrite, nullptr);
+    }
+
+}
+
+int main() {
+    std::cout << "=== SCHEDULER LATENESS (write time - deadline) ===\n";
+    runSleeping();
+    runScheduled(false);
+    runScheduled(true);
+    return 0;
+}
@@ -0,0 +1,89 @@
+// Receive spin window against latency and CPU: back-to-back queries, so
+// each reply lands shortly after the previous burst, for spin windows
+// from 0 (always block) to 200 us. Reports round-trip percentiles,
+// process CPU per query, the listener's spin counters and idle CPU over
+// the second after the traffic stops.
+//
+// Build: bench/build_benchmarks.sh
+
+#include "../include/serialport.h"
+#include "fake_device.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    double cpuUs() {
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e6 +
+            (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+    }
+
+    void run(std::chrono::microseconds spin) {
+        const int queries = 5000;
+
+        FakeDevice device;
+        makcu::SerialPort port;
+        if (!device.isValid() || !port.open(device.name(), 4000000)) {
+            std::cout << "Failed to open the fake device\n";
+            return;
+        }
+        port.setReceiveSpinTime(spin);
+
+        std::string response;
+        for (int i = 0; i < 100; ++i) {
+            port.query("km.version()", response, std::chrono::milliseconds(100));
+        }
+        makcu::ReceiveStats before = port.getReceiveStats();
+
+        std::vector<double> roundTrips;
+        roundTrips.reserve(queries);
+        double cpuStart = cpuUs();
+        for (int i = 0; i < queries; ++i) {
+            auto start = Clock::now();
+            if (port.query("km.version()", response, std::chrono::milliseconds(100))) {
+                roundTrips.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+            }
+        }
+        double cpuPerQuery = (cpuUs() - cpuStart) / queries;
+        makcu::ReceiveStats after = port.getReceiveStats();
+
+        double idleStart = cpuUs();
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        double idleCpu = (cpuUs() - idleStart) / 1000.0;
+        port.close();
+
+        std::sort(roundTrips.begin(), roundTrips.end());
+        auto percentile = [&](double p) {
+            return roundTrips.empty() ? 0.0 : roundTrips[std::min(roundTrips.size() - 1, static_cast<size_t>(p * roundTrips.size()))];
+        };
+        uint64_t hits = after.spinHits - before.spinHits;
+        uint64_t timeouts = after.spinTimeouts - before.spinTimeouts;
+        std::cout << "spin " << std::setw(4) << spin.count() << " us" << std::fixed << std::setprecision(1)
+            << "  rtt p50 " << std::setw(6) << percentile(0.5) << " p99 " << std::setw(7) << percentile(0.99) << " us"
+            << "  CPU " << std::setw(6) << cpuPerQuery << " us/query"
+            << "  hits " << std::setw(5) << hits << " timeouts " << std::setw(5) << timeouts
+            << " parks " << std::setw(5) << after.parks - before.parks
+            << "  spun " << std::setw(7) << (after.spinNs - before.spinNs) / 1e6 << " ms"
+            << "  idle CPU " << std::setw(5) << idleCpu << " ms/s\n";
+    }
+
+}
+
+int main() {
+    std::cout << "=== RECEIVE SPIN WINDOW ===\n";
+    for (int spin : { 0, 10, 25, 50, 100, 200 }) {
+        run(std::chrono::microseconds(spin));
+    }
+    return 0;
+}
@@ -0,0 +1,134 @@
+// Per-command cost of the serial transports: poll() with write(2), an
+// io_uring whose writes are submitted with io_uring_enter(), and an
+// io_uring with a kernel SQPOLL thread. A burst of moves measures caller
+// cost, delivery time and process CPU per command; single moves 200 us
+// apart measure the idle submission path; queries measure the round trip.
+// CPU is the whole process; since Linux 5.12 that includes the SQPOLL
+// thread, which spins for sq_thread_idle after every submission.
+//
+// Build: bench/build_benchmarks.sh
+
+#include "../include/serialport.h"
+#include "fake_device.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    double nsSince(Clock::time_point start) {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+
+    double cpuNs() {
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e9 +
+            (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e3;
+    }
+
+    double percentile(std::vector<double>& samples, double p) {
+        std::sort(samples.begin(), samples.end());
+        return samples.empty() ? 0.0 : samples[std::min(samples.size() - 1, static_cast<size_t>(p * samples.size()))];
+    }
+
+    bool waitForBytes(const FakeDevice& device, uint64_t target) {
+        auto deadline = Clock::now() + std::chrono::seconds(10);
+        while (device.bytesReceived() < target) {
+            if (Clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        return true;
+    }
+
+    void run(const char* label, makcu::IoBackend backend, bool sqPoll) {
+        const int burst = 100000;
+        const int singles = 2000;
+        const int queries = 2000;
+
+        FakeDevice device;
+        makcu::SerialPort port;
+        if (!port.setIoBackend(backend, sqPoll)) {
+            std::cout << std::left << std::setw(16) << label << " unavailable on this system\n";
+            return;
+        }
+        if (!device.isValid() || !port.open(device.name(), 4000000)) {
+            std::cout << "Failed to open the fake device\n";
+            return;
+        }
+        bool active = port.getIoBackend() == backend && port.isSqPolling() == sqPoll;
+
+        // Bytes per move, and a warm path
+        uint64_t before = device.bytesReceived();
+        port.sendMove(1, 0);
+        waitForBytes(device, before + 1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        uint64_t moveBytes = device.bytesReceived() - before;
+
+        // Burst
+        before = device.bytesReceived();
+        double cpuStart = cpuNs();
+        auto start = Clock::now();
+        for (int i = 0; i < burst; ++i) {
+            port.sendMove(1, 0);
+        }
+        double callNs = nsSince(start) / burst;
+        bool delivered = waitForBytes(device, before + moveBytes * burst);
+        double deliverNs = nsSince(start) / burst;
+        double burstCpuNs = (cpuNs() - cpuStart) / burst;
+
+        // Single moves on an idle transport
+        std::vector<double> single;
+        single.reserve(singles);
+        cpuStart = cpuNs();
+        for (int i = 0; i < singles; ++i) {
+            auto call = Clock::now();
+            port.sendMove(1, 0);
+            single.push_back(nsSince(call));
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        double singleCpuNs = (cpuNs() - cpuStart) / singles;
+
+        // Query round trips
+        std::vector<double> roundTrips;
+        roundTrips.reserve(queries);
+        std::string response;
+        for (int i = 0; i < queries; ++i) {
+            auto call = Clock::now();
+            if (port.query("km.version()", response, std::chrono::milliseconds(100))) {
+                roundTrips.push_back(nsSince(call));
+            }
+        }
+        port.close();
+
+        std::cout << std::left << std::setw(16) << label << std::right << std::fixed << std::setprecision(0)
+            << " burst " << std::setw(6) << callNs << " ns/call " << std::setw(6) << deliverNs << " ns/delivered "
+            << std::setw(6) << burstCpuNs << " ns CPU"
+            << " | single p50 " << std::setw(6) << percentile(single, 0.5) << " p99 " << std::setw(7) << percentile(single, 0.99)
+            << " ns, " << std::setw(6) << singleCpuNs << " ns CPU"
+            << " | query p50 " << std::setprecision(1) << std::setw(6) << percentile(roundTrips, 0.5) / 1000.0
+            << " p99 " << std::setw(7) << percentile(roundTrips, 0.99) / 1000.0 << " us"
+            << (delivered ? "" : " [burst not delivered]") << (active ? "" : " [fell back]") << "\n";
+    }
+
+}
+
+int main() {
+    std::cout << "=== IO BACKEND COST PER COMMAND ===\n";
+    for (int round = 0; round < 2; ++round) {
+        run("poll", makcu::IoBackend::POLL, false);
+        run("io_uring", makcu::IoBackend::IO_URING, false);
+        run("io_uring+SQPOLL", makcu::IoBackend::IO_URING, true);
+    }
+    return 0;
+}
@@ -0,0 +1,108 @@
+// Bytes on the wire per command, ASCII vs binary frames. The fake device
+// decodes what it received and checks the summed move deltas.
+//
+// Build: bench/build_benchmarks.sh
+
+#include "../include/serialport.h"
+#include "fake_device.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+namespace {
+
+    struct Totals {
+        int64_t x = 0;
+        int64_t y = 0;
+        size_t moves = 0;
+    };
+
+    // Frames: DE AD | u16 LE length | opcode | payload; move is 0xB1 i16 dx, i16 dy
+    Totals decodeBinary(const std::string& wire) {
+        Totals totals;
+        auto byte = [&](size_t i) { return static_cast<uint8_t>(wire[i]); };
+        for (size_t i = 0; i + 5 <= wire.size();) {
+            if (byte(i) != 0xDE || byte(i + 1) != 0xAD) {
+                std::cout << "   desync at byte " << i << "\n";
+                break;
+            }
+            size_t length = byte(i + 2) | (byte(i + 3) << 8);
+            if (byte(i + 4) == 0xB1 && i + 9 <= wire.size()) {
+                totals.x += static_cast<int16_t>(byte(i + 5) | (byte(i + 6) << 8));
+                totals.y += static_cast<int16_t>(byte(i + 7) | (byte(i + 8) << 8));
+                ++totals.moves;
+            }
+            i += 4 + length;
+        }
+        return totals;
+    }
+
+    Totals decodeAscii(const std::string& wire) {
+        Totals totals;
+        for (size_t pos = 0; (pos = wire.find("km.move(", pos)) != std::string::npos; pos += 8) {
+            totals.x += std::atol(wire.c_str() + pos + 8);
+            totals.y += std::atol(wire.c_str() + wire.find(',', pos) + 1);
+            ++totals.moves;
+        }
+        return totals;
+    }
+
+    void run(makcu::WireProtocol protocol) {
+        const bool binary = protocol == makcu::WireProtocol::BINARY;
+        const int moves = 100000;
+        const double lineBytesPerSecond = 4000000.0 / 10;  // 4 Mbaud, 8N1
+
+        FakeDevice device(true);
+        makcu::SerialPort port;
+        if (!device.isValid() || !port.open(device.name(), 4000000)) {
+            std::cout << "Failed to open the fake device\n";
+            return;
+        }
+        port.setWireProtocol(protocol);
+
+        // Mostly small deltas with one that needs splitting into int16 frames
+        std::mt19937 rng(1);
+        std::uniform_int_distribution<int> delta(-200, 200);
+        int64_t sumX = 0;
+        int64_t sumY = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < moves; ++i) {
+            int x = i == 5 ? 100000 : delta(rng);
+            int y = delta(rng);
+            sumX += x;
+            sumY += y;
+            port.sendMove(x, y);
+        }
+        port.sendButton(makcu::MouseButton::LEFT, true);
+        port.sendButton(makcu::MouseButton::LEFT, false);
+        port.sendWheel(-3);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        uint64_t written = port.getWriterStats().bytesWritten;
+        port.flush();
+        port.close();
+        for (int wait = 0; wait < 100 && device.bytesReceived() < written; ++wait) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        std::string wire = device.takeCaptured();
+        Totals totals = binary ? decodeBinary(wire) : decodeAscii(wire);
+
+        double perMove = static_cast<double>(written) / moves;
+        std::cout << (binary ? "binary" : "ascii ") << std::fixed << std::setprecision(2)
+            << ": " << written << " bytes (" << perMove << " B/move), "
+            << totals.moves << " move frames, sums " << (totals.x == sumX && totals.y == sumY ? "match" : "MISMATCH")
+            << std::setprecision(0) << ", send " << moves / seconds / 1e3 << " k moves/s"
+            << ", 4 Mbaud ceiling " << lineBytesPerSecond / perMove / 1e3 << " k moves/s\n";
+    }
+
+}
+
+int main() {
+    std::cout << "=== WIRE PROTOCOL ===\n";
+    run(makcu::WireProtocol::ASCII);
+    run(makcu::WireProtocol::BINARY);
+    return 0;
+}
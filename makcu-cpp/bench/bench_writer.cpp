@@ -0,0 +1,117 @@
+// Outbound throughput with and without the writer thread: 1 and 4
+// producer threads each send 50000 moves, written inline on the caller's
+// thread, through the writer with coalescing off, and with it on.
+// Reports caller cost, time until everything was handed to the OS,
+// commands per write() and the writer's enqueue-to-wire latency.
+//
+// Build: bench/build_benchmarks.sh
+
+#include "../include/serialport.h"
+#include "fake_device.h"
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+
+// Count command writes; 8-byte writes are eventfd wakeups
+namespace bench {
+    inline std::atomic<uint64_t> g_writes{ 0 };
+}
+
+extern "C" ssize_t write(int fd, const void* data, size_t length) {
+    if (length != 8) {
+        bench::g_writes.fetch_add(1, std::memory_order_relaxed);
+    }
+    return static_cast<ssize_t>(::syscall(SYS_write, fd, data, length));
+}
+#endif
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    uint64_t writes() {
+#if defined(__linux__)
+        return bench::g_writes.load(std::memory_order_relaxed);
+#else
+        return 0;
+#endif
+    }
+
+    enum class Mode { INLINE, WRITER, COALESCING };
+
+    void run(Mode mode, int producers) {
+        const int perProducer = 50000;
+        const uint64_t total = static_cast<uint64_t>(perProducer) * producers;
+
+        FakeDevice device;
+        makcu::SerialPort port;
+        if (!device.isValid() || !port.open(device.name(), 4000000)) {
+            std::cout << "Failed to open the fake device\n";
+            return;
+        }
+        port.setCoalescingEnabled(mode == Mode::COALESCING);
+        port.setWriterThreadEnabled(mode != Mode::INLINE);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        makcu::WriterStats before = port.getWriterStats();
+        uint64_t writesBefore = writes();
+        std::atomic<int64_t> callerNs{ 0 };
+        auto start = Clock::now();
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&] {
+                auto begin = Clock::now();
+                for (int i = 0; i < perProducer; ++i) {
+                    port.sendMove(1, -1);
+                }
+                callerNs += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count();
+                });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        // Done once the writer has handed every queued command to the OS
+        makcu::WriterStats after = port.getWriterStats();
+        while (mode != Mode::INLINE &&
+            after.commandsWritten - before.commandsWritten + after.movesMerged - before.movesMerged < total) {
+            std::this_thread::yield();
+            after = port.getWriterStats();
+        }
+        double elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        uint64_t syscalls = writes() - writesBefore;
+        port.close();
+
+        const char* label = mode == Mode::INLINE ? "inline" : mode == Mode::WRITER ? "writer" : "writer+coalescing";
+        uint64_t written = after.commandsWritten - before.commandsWritten;
+        std::cout << std::left << std::setw(18) << label << std::right << " producers=" << producers
+            << std::fixed << std::setprecision(0)
+            << "  caller " << std::setw(5) << static_cast<double>(callerNs.load()) / total << " ns/cmd"
+            << std::setprecision(2) << "  " << std::setw(5) << total / elapsedMs / 1000.0 << " Mcmd/s"
+            << "  " << std::setw(7) << (syscalls ? static_cast<double>(total) / syscalls : 0.0) << " cmd/write";
+        if (mode != Mode::INLINE) {
+            std::cout << std::setprecision(1) << "  latency avg " << std::setw(7)
+                << (written ? (after.totalLatencyNs - before.totalLatencyNs) / 1000.0 / written : 0.0) << " us"
+                << "  max " << std::setw(8) << after.maxLatencyNs / 1000.0 << " us"
+                << "  queue-full waits " << after.queueFullWaits - before.queueFullWaits;
+        }
+        std::cout << "\n";
+    }
+
+}
+
+int main() {
+    std::cout << "=== WRITER THREAD THROUGHPUT ===\n";
+    for (int producers : { 1, 4 }) {
+        run(Mode::INLINE, producers);
+        run(Mode::WRITER, producers);
+        run(Mode::COALESCING, producers);
+    }
+    return 0;
+}
@@ -0,0 +1,66 @@
+#!/bin/bash
+# Build the MAKCU microbenchmarks into bench/bin
+# Usage: bench/build_benchmarks.sh [--run]
+
+BENCH_DIR="$(cd "$(dirname "$0")" && pwd)"
+ROOT_DIR="$(dirname "$BENCH_DIR")"
+OUT_DIR="$BENCH_DIR/bin"
+
+if command -v g++ &> /dev/null; then
+    COMPILER="g++"
+elif command -v clang++ &> /dev/null; then
+    COMPILER="clang++"
+else
+    echo "❌ Error: No C++ compiler found (g++ or clang++)"
+    exit 1
+fi
+
+FLAGS="-std=c++17 -O2 -I$ROOT_DIR/include"
+LIBRARY="$ROOT_DIR/src/makcu.cpp $ROOT_DIR/src/serialport.cpp"
+LIBS="-pthread"
+if [[ "$OSTYPE" == "linux-gnu"* ]]; then
+    LIBS="$LIBS -lutil"  # openpty() for the fake device
+fi
+
+mkdir -p "$OUT_DIR"
+BENCHMARKS=()
+
+# build <name> <source> [extra flags...]
+build() {
+    local name="$1"
+    local source="$2"
+    shift 2
+    echo "Building $name..."
+    if ! $COMPILER $FLAGS "$@" "$BENCH_DIR/$source" $LIBRARY -o "$OUT_DIR/$name" $LIBS; then
+        echo "❌ Error: $name failed to build"
+        exit 1
+    fi
+    BENCHMARKS+=("$name")
+}
+
+build bench_parser bench_parser.cpp
+if grep -qw avx2 /proc/cpuinfo 2> /dev/null; then
+    build bench_parser_avx2 bench_parser.cpp -mavx2
+fi
+build bench_wire bench_wire.cpp
+build bench_jitter bench_jitter.cpp
+build bench_alloc bench_alloc.cpp
+build bench_batch bench_batch.cpp
+build bench_uring bench_uring.cpp
+build bench_replay bench_replay.cpp
+build bench_priority bench_priority.cpp
+build bench_schedule bench_schedule.cpp
+build bench_wakeup bench_wakeup.cpp
+build bench_writer bench_writer.cpp
+build bench_spin bench_spin.cpp
+build bench_async bench_async.cpp
+build bench_parser_scalar bench_parser.cpp -DMAKCU_NO_SIMD
+
+echo "✅ Benchmarks built in $OUT_DIR"
+
+if [ "$1" == "--run" ]; then
+    for name in "${BENCHMARKS[@]}"; do
+        echo ""
+        "$OUT_DIR/$name" || exit 1
+    done
+fi
@@ -0,0 +1,129 @@
+#pragma once
+
+// MAKCU stand-in on a pseudo-terminal (Linux/macOS) for the benchmarks. The
+// library opens name(); a thread drains the other side, counts (and
+// optionally keeps) what was written and answers id-tagged queries the
+// way the firmware does: "km.version()#7" -> "km.version()#7:km.MAKCU"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#if defined(__APPLE__)
+#include <util.h>
+#else
+#include <pty.h>
+#endif
+
+class FakeDevice {
+public:
+    explicit FakeDevice(bool capture = false) : m_capture(capture) {
+        char name[128] = {};
+        if (openpty(&m_master, &m_slave, name, nullptr, nullptr) != 0) {
+            return;
+        }
+        termios tio{};
+        tcgetattr(m_master, &tio);
+        cfmakeraw(&tio);
+        tcsetattr(m_master, TCSANOW, &tio);
+        m_name = name;
+        m_thread = std::thread(&FakeDevice::run, this);
+    }
+
+    ~FakeDevice() {
+        m_stop = true;
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+        if (m_master >= 0) {
+            ::close(m_master);
+        }
+        if (m_slave >= 0) {
+            ::close(m_slave);
+        }
+    }
+
+    bool isValid() const { return !m_name.empty(); }
+    const std::string& name() const { return m_name; }
+    uint64_t bytesReceived() const { return m_bytes.load(); }
+
+    // Everything written so far (capture mode only)
+    std::string takeCaptured() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::string captured;
+        captured.swap(m_captured);
+        return captured;
+    }
+
+    // Bytes from the "device" to the host, e.g. button masks
+    bool send(const void* data, size_t length) {
+        return ::write(m_master, data, length) == static_cast<ssize_t>(length);
+    }
+
+private:
+    // Allocation-free while no query is answered, so the allocation
+    // benchmark can count every thread
+    void run() {
+        std::string pending;
+        pending.reserve(2 * READ_SIZE);
+        char buffer[READ_SIZE];
+        pollfd pfd{ m_master, POLLIN, 0 };
+        while (!m_stop) {
+            if (::poll(&pfd, 1, 5) <= 0) {
+                continue;
+            }
+            ssize_t n = ::read(m_master, buffer, sizeof(buffer));
+            if (n <= 0) {
+                continue;
+            }
+            m_bytes += static_cast<uint64_t>(n);
+            if (m_capture) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_captured.append(buffer, static_cast<size_t>(n));
+            }
+
+            // Answer tagged queries; everything else is fire-and-forget
+            pending.append(buffer, static_cast<size_t>(n));
+            size_t start = 0;
+            size_t end;
+            while ((end = pending.find('\n', start)) != std::string::npos) {
+                std::string_view line(pending.data() + start, end - start);
+                start = end + 1;
+                if (!line.empty() && line.back() == '\r') {
+                    line.remove_suffix(1);
+                }
+                size_t command = line.find("km.");
+                if (command != std::string_view::npos && line.find('#', command) != std::string_view::npos) {
+                    std::string reply = std::string(line.substr(command)) + ":km.MAKCU\r\n";
+                    send(reply.data(), reply.size());
+                }
+            }
+            pending.erase(0, start);
+            if (pending.size() > READ_SIZE) {
+                pending.clear();  // Binary frames, no line to answer
+            }
+        }
+    }
+
+    static constexpr size_t READ_SIZE = 65536;
+
+    bool m_capture;
+    int m_master = -1;
+    int m_slave = -1;
+    std::string m_name;
+    std::thread m_thread;
+    std::atomic<bool> m_stop{ false };
+    std::atomic<uint64_t> m_bytes{ 0 };
+    std::mutex m_mutex;
+    std::string m_captured;
+
+    FakeDevice(const FakeDevice&) = delete;
+    FakeDevice& operator=(const FakeDevice&) = delete;
+};
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <array>
 #include <memory>
 #include <functional>
 #include <cstdint>
@@ -10,6 +12,8 @@
 #include <atomic>
 #include <future>
 #include <chrono>
+#include <mutex>
+#include <condition_variable>
 
 namespace makcu {
 
@@ -25,6 +29,41 @@ namespace makcu {
         SIDE2 = 4
     };
 
+    // Axes and buttons that can be locked (bit index in LockStates::mask)
+    enum class LockTarget : uint8_t {
+        X = 0,
+        Y = 1,
+        LEFT = 2,
+        RIGHT = 3,
+        MIDDLE = 4,
+        SIDE1 = 5,
+        SIDE2 = 6
+    };
+    constexpr size_t LOCK_TARGET_COUNT = 7;
+    constexpr std::array<LockTarget, LOCK_TARGET_COUNT> ALL_LOCK_TARGETS = {
+        LockTarget::X, LockTarget::Y, LockTarget::LEFT, LockTarget::RIGHT,
+        LockTarget::MIDDLE, LockTarget::SIDE1, LockTarget::SIDE2
+    };
+
+    // Encoding used for move/wheel/button commands on the wire
+    enum class WireProtocol {
+        ASCII,      // km.move(x,y)\r\n ... (always supported)
+        BINARY      // DE AD length-prefixed frames, negotiated at connect
+    };
+
+    enum class IoBackend {
+        POLL,       // read/write syscalls, poll() wakeups (all platforms)
+        IO_URING    // Linux 5.6+: armed read SQE, coalesced ring-submitted writes
+    };
+
+    // Outbound classes, highest priority first (see Device::enablePriorityClasses)
+    enum class CommandPriority : uint8_t {
+        CONTROL = 0,    // Button presses/releases, km.buttons, locks
+        MOTION = 1,     // Moves and wheel steps
+        QUERY = 2       // Commands awaiting a reply, info and configuration
+    };
+    constexpr size_t COMMAND_PRIORITY_COUNT = 3;
+
     enum class ConnectionStatus {
         DISCONNECTED,
         CONNECTING,
@@ -41,6 +80,202 @@ namespace makcu {
         bool isConnected;
     };
 
+    // Cached lock state of every LockTarget, one bit each
+    struct LockStates {
+        uint8_t mask = 0;
+
+        bool isLocked(LockTarget target) const {
+            return (mask >> static_cast<uint8_t>(target)) & 1u;
+        }
+
+        bool any() const { return mask != 0; }
+    };
+
+    // Outbound writer thread counters (see Device::enableWriterThread)
+    struct WriterStats {
+        uint64_t commandsQueued = 0;      // Commands accepted by the queue
+        uint64_t commandsWritten = 0;     // Commands handed to the OS
+        uint64_t writeSyscalls = 0;       // write()/WriteFile calls issued by the writer
+        uint64_t writeErrors = 0;         // Failed or short writes
+        uint64_t queueFullWaits = 0;      // Producer retries because the ring was full
+        uint64_t totalLatencyNs = 0;      // Sum of enqueue-to-wire latencies
+        uint64_t maxLatencyNs = 0;        // Worst enqueue-to-wire latency
+        uint64_t movesMerged = 0;         // Queued km.move commands folded into a neighbour
+        uint64_t wheelsMerged = 0;        // Queued km.wheel commands folded into a neighbour
+        uint64_t pacedTicks = 0;          // Pacing ticks that released a move/wheel
+        uint64_t pacingJitterNs = 0;      // Sum of (release time - tick time)
+        uint64_t maxPacingJitterNs = 0;   // Worst release lateness vs. the tick grid
+        uint64_t bytesWritten = 0;        // Bytes handed to the OS (all write paths)
+
+        // Enqueue-to-wire delay of each class, indexed by CommandPriority
+        struct ClassDelay {
+            uint64_t commands = 0;        // Commands of this class written
+            uint64_t totalDelayNs = 0;
+            uint64_t maxDelayNs = 0;
+            uint64_t promotions = 0;      // Drains led by this class because it waited past the starvation limit
+
+            double averageDelayUs() const {
+                return commands ? totalDelayNs / 1000.0 / commands : 0.0;
+            }
+        };
+        ClassDelay classes[COMMAND_PRIORITY_COUNT];
+
+        const ClassDelay& delayOf(CommandPriority priority) const {
+            return classes[static_cast<size_t>(priority)];
+        }
+
+        double commandsPerSyscall() const {
+            return writeSyscalls ? static_cast<double>(commandsWritten) / writeSyscalls : 0.0;
+        }
+
+        double averageLatencyUs() const {
+            return commandsWritten ? totalLatencyNs / 1000.0 / commandsWritten : 0.0;
+        }
+
+        double averagePacingJitterUs() const {
+            return pacedTicks ? pacingJitterNs / 1000.0 / pacedTicks : 0.0;
+        }
+    };
+
+    // Listener line-assembly counters
+    struct ReceiveStats {
+        uint64_t linesZeroCopy = 0;       // Lines parsed straight from the read buffer
+        uint64_t linesAssembled = 0;      // Lines split across reads, assembled in the arena
+        uint64_t linesDropped = 0;        // Lines longer than the arena limit (discarded whole)
+        uint64_t longestLine = 0;         // High-water mark of line length
+        uint64_t arenaCapacity = 0;       // High-water mark of the line arena (never shrinks)
+        uint64_t spinHits = 0;            // Reads satisfied inside the spin window (no wakeup)
+        uint64_t spinTimeouts = 0;        // Spin windows that expired and fell back to blocking
+        uint64_t parks = 0;               // Blocking waits entered
+        uint64_t spinNs = 0;              // Total time spent spinning
+
+        double spinHitRate() const {
+            uint64_t windows = spinHits + spinTimeouts;
+            return windows ? static_cast<double>(spinHits) / windows : 0.0;
+        }
+    };
+
+    // Opt-in determinism for the serial port's internal threads. Every
+    // setting is best effort; RealtimeStatus reports what the OS granted
+    struct RealtimeConfig {
+        bool enabled = false;
+        int listenerCpu = -1;             // Pin the listener to this CPU (-1 = no pinning)
+        int writerCpu = -1;               // Pin writer and scheduler threads (-1 = no pinning)
+        int priority = 80;                // SCHED_FIFO 1-99 (Windows: time critical), 0 = unchanged
+        bool lockMemory = true;           // mlockall (process-wide), prefaulted stacks and buffers
+        bool lowLatencyTty = true;        // ASYNC_LOW_LATENCY (Linux serial drivers)
+    };
+
+    struct RealtimeStatus {
+        bool affinity = false;            // Requested pinning applied on every thread so far
+        bool priority = false;            // Requested real-time priority applied on every thread so far
+        bool memoryLocked = false;
+        bool lowLatencyTty = false;
+    };
+
+    // Timer-scheduler counters: lateness = actual submit time - scheduled deadline
+    struct ScheduleStats {
+        uint64_t fired = 0;               // Scheduled commands submitted to the port
+        uint64_t cancelled = 0;           // Scheduled commands dropped by cancel()/close()
+        uint64_t totalLatenessNs = 0;
+        uint64_t maxLatenessNs = 0;
+
+        double averageLatenessUs() const {
+            return fired ? totalLatenessNs / 1000.0 / fired : 0.0;
+        }
+    };
+
+    // Cancellable handle to commands queued on the device's timer thread
+    class ScheduledAction {
+    public:
+        struct State {
+            std::atomic<bool> cancelled{ false };
+            std::atomic<uint32_t> remaining{ 0 };
+            std::atomic<uint32_t> failed{ 0 };
+            std::mutex mutex;
+            std::condition_variable done;
+            // Under mutex: buttons pressed by fired steps and not released
+            // yet (bit = MouseButton), and the scheduler's hook that releases
+            // them, set while steps are queued
+            uint8_t held = 0;
+            std::function<void(uint8_t)> releaseHeld;
+        };
+
+        ScheduledAction() = default;
+        explicit ScheduledAction(std::shared_ptr<State> state) : m_state(std::move(state)) {}
+
+        // Drop every step that has not fired yet; false if nothing was pending.
+        // Buttons whose press already fired are released right away
+        bool cancel();
+        bool isPending() const;
+
+        // Block until all steps fired (true if every write succeeded) or the
+        // action was cancelled (false)
+        bool wait();
+
+    private:
+        std::shared_ptr<State> m_state;
+    };
+
+    // One step of a sequence for Device::prepare(); delay is measured from
+    // the previous step (or from the start of the replay)
+    struct SequenceStep {
+        enum class Kind : uint8_t { MOVE, WHEEL, PRESS, RELEASE };
+
+        Kind kind = Kind::MOVE;
+        int32_t x = 0;                    // Move dx / wheel delta
+        int32_t y = 0;                    // Move dy
+        uint32_t segments = 0;            // Moves: > 0 for km.move(x,y,segments) (ASCII)
+        MouseButton button = MouseButton::LEFT;
+        std::chrono::microseconds delay{ 0 };
+
+        static SequenceStep move(int32_t x, int32_t y,
+            std::chrono::microseconds delay = std::chrono::microseconds(0), uint32_t segments = 0) {
+            return { Kind::MOVE, x, y, segments, MouseButton::LEFT, delay };
+        }
+        static SequenceStep wheel(int32_t delta, std::chrono::microseconds delay = std::chrono::microseconds(0)) {
+            return { Kind::WHEEL, delta, 0, 0, MouseButton::LEFT, delay };
+        }
+        static SequenceStep press(MouseButton button, std::chrono::microseconds delay = std::chrono::microseconds(0)) {
+            return { Kind::PRESS, 0, 0, 0, button, delay };
+        }
+        static SequenceStep release(MouseButton button, std::chrono::microseconds delay = std::chrono::microseconds(0)) {
+            return { Kind::RELEASE, 0, 0, 0, button, delay };
+        }
+    };
+
+    // Applied to every move of a replay: dx * scaleX + offsetX (likewise y).
+    // Scaled remainders carry over to the next move so totals do not drift
+    struct ReplayTransform {
+        double scaleX = 1.0;
+        double scaleY = 1.0;
+        int32_t offsetX = 0;
+        int32_t offsetY = 0;
+
+        bool isIdentity() const {
+            return scaleX == 1.0 && scaleY == 1.0 && offsetX == 0 && offsetY == 0;
+        }
+    };
+
+    // Immutable command sequence encoded once by Device::prepare(): wire bytes
+    // plus a table of relative submit times. Steps due at the same time share
+    // one write. Copies share the encoding
+    class PreparedSequence {
+    public:
+        PreparedSequence() = default;
+
+        bool isValid() const { return m_data != nullptr; }
+        size_t size() const;                          // Steps
+        std::chrono::microseconds duration() const;   // Offset of the last step
+        WireProtocol protocol() const;
+
+    private:
+        friend class Device;
+        struct Data;
+        explicit PreparedSequence(std::shared_ptr<const Data> data) : m_data(std::move(data)) {}
+        std::shared_ptr<const Data> m_data;
+    };
+
     struct MouseButtonStates {
         bool left;
         bool right;
@@ -108,6 +343,9 @@ namespace makcu {
         // Callback types
         using MouseButtonCallback = std::function<void(MouseButton, bool)>;
         using ConnectionCallback = std::function<void(bool)>;
+        // Called after an automatic reconnect with the outage duration (from
+        // failure detection to restored session) and the reopen attempts used
+        using ReconnectCallback = std::function<void(std::chrono::microseconds, uint32_t)>;
 
         // Constructor and destructor
         Device();
@@ -123,7 +361,7 @@ namespace makcu {
         bool isConnected() const;
         ConnectionStatus getStatus() const;
 
-        // Async connection methods
+        // Async connection methods (run on the device's worker threads)
         std::future<bool> connectAsync(const std::string& port = "");
         std::future<void> disconnectAsync();
 
@@ -137,7 +375,8 @@ namespace makcu {
         bool mouseUp(MouseButton button);
         bool click(MouseButton button);  // Combined press+release
 
-        // Async mouse button control
+        // Async mouse button control: the command is written or queued on the
+        // calling thread and the returned future is already ready
         std::future<bool> mouseDownAsync(MouseButton button);
         std::future<bool> mouseUpAsync(MouseButton button);
         std::future<bool> clickAsync(MouseButton button);
@@ -152,7 +391,7 @@ namespace makcu {
         bool mouseMoveBezier(int32_t x, int32_t y, uint32_t segments,
             int32_t ctrl_x, int32_t ctrl_y);
 
-        // Async movement
+        // Async movement (ready future, no thread hop)
         std::future<bool> mouseMoveAsync(int32_t x, int32_t y);
         std::future<bool> mouseMoveSmoothAsync(int32_t x, int32_t y, uint32_t segments);
         std::future<bool> mouseMoveBezierAsync(int32_t x, int32_t y, uint32_t segments,
@@ -163,6 +402,7 @@ namespace makcu {
         std::future<bool> mouseWheelAsync(int32_t delta);
 
         // Mouse locking with state caching
+        bool lockMouse(LockTarget target, bool lock = true);
         bool lockMouseX(bool lock = true);
         bool lockMouseY(bool lock = true);
         bool lockMouseLeft(bool lock = true);
@@ -172,6 +412,7 @@ namespace makcu {
         bool lockMouseSide2(bool lock = true);
 
         // Fast lock state queries (cached)
+        bool isLocked(LockTarget target) const;
         bool isMouseXLocked() const;
         bool isMouseYLocked() const;
         bool isMouseLeftLocked() const;
@@ -180,8 +421,8 @@ namespace makcu {
         bool isMouseSide1Locked() const;
         bool isMouseSide2Locked() const;
 
-        // Batch lock state query
-        std::unordered_map<std::string, bool> getAllLockStates() const;
+        // Batch lock state query: one load of the cached bits
+        LockStates getAllLockStates() const;
 
         // Mouse input catching
         uint8_t catchMouseLeft();
@@ -210,18 +451,102 @@ namespace makcu {
         // Callbacks
         void setMouseButtonCallback(MouseButtonCallback callback);
         void setConnectionCallback(ConnectionCallback callback);
+        void setReconnectCallback(ReconnectCallback callback);
+
+        // On a read error/EOF the port is reopened with bounded backoff, the
+        // 4 Mbaud switch redone and button monitoring and locks replayed.
+        // ConnectionCallback sees false then true. Default on
+        void enableAutoReconnect(bool enable = true);
+        bool isAutoReconnectEnabled() const;
 
         // High-level automation
         bool clickSequence(const std::vector<MouseButton>& buttons,
             std::chrono::milliseconds delay = std::chrono::milliseconds(50));
+
+        // Timer-scheduled actions: return immediately, commands are written by
+        // an internal timer thread at absolute steady_clock deadlines
+        using TimePoint = std::chrono::steady_clock::time_point;
+        ScheduledAction scheduleMouseDown(MouseButton button, TimePoint at);
+        ScheduledAction scheduleMouseUp(MouseButton button, TimePoint at);
+        ScheduledAction scheduleClick(MouseButton button, TimePoint at,
+            std::chrono::milliseconds holdFor = std::chrono::milliseconds(0));
+        ScheduledAction clickSequenceAsync(const std::vector<MouseButton>& buttons,
+            std::chrono::milliseconds delay = std::chrono::milliseconds(50));
+        ScheduleStats getScheduleStats() const;
         bool movePattern(const std::vector<std::pair<int32_t, int32_t>>& points,
             bool smooth = true, uint32_t segments = 10);
 
+        // Encode a sequence once in the current wire protocol (invalid on an
+        // unknown button). A replay writes the steps due at once directly and
+        // hands only delayed steps to the timer thread, without re-encoding
+        // unless a transform changes the moves. A replay fails if
+        // the wire protocol changed since prepare()
+        PreparedSequence prepare(const std::vector<SequenceStep>& steps) const;
+        bool replay(const PreparedSequence& sequence, const ReplayTransform& transform = {});
+        ScheduledAction replayAsync(const PreparedSequence& sequence, const ReplayTransform& transform = {});
+
         // Performance utilities
         void enableHighPerformanceMode(bool enable = true);
         bool isHighPerformanceModeEnabled() const;
 
-        // Command batching for maximum performance
+        // Queue commands to a dedicated writer thread that coalesces them into
+        // one write per wakeup instead of one blocking write per call
+        void enableWriterThread(bool enable = true);
+        bool isWriterThreadEnabled() const;
+        WriterStats getWriterStats() const;
+
+        // Merge backed-up moves/wheel steps in the writer queue (default on)
+        void enableMoveCoalescing(bool enable = true);
+        bool isMoveCoalescingEnabled() const;
+
+        // Fixed-rate output pacing aligned to the device's USB report interval:
+        // at most one aggregated move per tick (e.g. 1000 or 8000 Hz, 0 = off,
+        // rates above 1 MHz are clamped to a 1 us tick). Implies the writer thread.
+        void setMovePacingRate(uint32_t ticksPerSecond);
+        uint32_t getMovePacingRate() const;
+
+        // Priority classes in the writer queue: buttons and locks overtake
+        // queued moves, which overtake queries; order within a class is kept.
+        // A class waiting longer than the starvation limit (default 2 ms) is
+        // drained first. Applies to commands queued afterwards; implies the
+        // writer thread
+        void enablePriorityClasses(bool enable = true);
+        bool isPriorityClassesEnabled() const;
+        void setStarvationLimit(std::chrono::microseconds limit);
+        std::chrono::microseconds getStarvationLimit() const;
+
+        ReceiveStats getReceiveStats() const;
+
+        // Busy-read window after each received burst before the listener
+        // blocks again (0 = always block); size it with ReceiveStats spin counters
+        void setReceiveSpinTime(std::chrono::microseconds spin);
+        std::chrono::microseconds getReceiveSpinTime() const;
+
+        // Real-time listener/writer threads (affinity, SCHED_FIFO, mlockall,
+        // ASYNC_LOW_LATENCY); kept across reconnects
+        bool setRealtimeMode(const RealtimeConfig& config);
+        RealtimeStatus getRealtimeStatus() const;
+
+        // Serial transport; io_uring takes effect from the next connect and
+        // falls back to poll() if the kernel refuses. False if unsupported
+        bool setIoBackend(IoBackend backend);
+        IoBackend getIoBackend() const;
+
+        // Compact binary frames for move/wheel/button commands. Negotiated now
+        // if connected and on every connect; falls back to ASCII when the
+        // firmware does not acknowledge. Returns true if binary is active
+        bool enableBinaryProtocol(bool enable);
+        WireProtocol getWireProtocol() const;
+
+        // Queries (version, catch*, serial) busy-wait this long for the reply
+        // before parking the caller; 0 (default) parks immediately
+        void setQuerySpinTime(std::chrono::microseconds spin);
+        std::chrono::microseconds getQuerySpinTime() const;
+
+        // Command batching for maximum performance. Commands are encoded into
+        // one buffer as they are added and execute() sends it as a single
+        // write; reset() empties the batch but keeps the buffer, so a builder
+        // can be rebuilt every frame without allocating.
         class BatchCommandBuilder {
         public:
             BatchCommandBuilder& move(int32_t x, int32_t y);
@@ -229,13 +554,22 @@ namespace makcu {
             BatchCommandBuilder& press(MouseButton button);
             BatchCommandBuilder& release(MouseButton button);
             BatchCommandBuilder& scroll(int32_t delta);
-            bool execute();
+            bool execute();  // Can be repeated; false if the wire protocol changed since encoding
+            void reset();
+
+            size_t size() const { return m_count; }
+            bool empty() const { return m_count == 0; }
 
         private:
             friend class Device;
             BatchCommandBuilder(Device* device) : m_device(device) {}
+            void beginCommand(CommandPriority priority);
+
             Device* m_device;
-            std::vector<std::string> m_commands;
+            std::vector<char> m_buffer;
+            size_t m_count = 0;
+            WireProtocol m_protocol = WireProtocol::ASCII;           // Taken at the first command
+            CommandPriority m_priority = CommandPriority::QUERY;    // Highest class in the batch
         };
 
         BatchCommandBuilder createBatch();
@@ -257,6 +591,7 @@ namespace makcu {
 
     // Utility functions
     std::string mouseButtonToString(MouseButton button);
+    std::string_view lockTargetName(LockTarget target);  // "X", "LEFT", ...
     MouseButton stringToMouseButton(const std::string& buttonName);
 
     // Performance profiling utilities
@@ -271,11 +606,11 @@ namespace makcu {
             s_enabled.store(enable);
         }
 
-        static void logCommandTiming(const std::string& command, std::chrono::microseconds duration) {
+        static void logCommandTiming(std::string_view command, std::chrono::microseconds duration) {
             if (!s_enabled.load()) return;
 
             std::lock_guard<std::mutex> lock(s_mutex);
-            auto& [count, total_us] = s_stats[command];
+            auto& [count, total_us] = s_stats[std::string(command)];
             count++;
             total_us += duration.count();
         }
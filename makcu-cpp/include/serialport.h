@@ -1,33 +1,381 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <atomic>
 #include <mutex>
+#include <condition_variable>
 #include <future>
 #include <unordered_map>
 #include <thread>
 #include <queue>
 #include <chrono>
+#include <array>
+#include <functional>
+#include <optional>
+#include <cstring>
+#include "makcu.h"
 
 #ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX  // Keep std::min/std::max and numeric_limits<T>::max() usable
+#endif
 #include <windows.h>
 #endif
 
 namespace makcu {
 
+    // USB ids of the MAKCU's serial bridge, for port discovery and DeviceInfo
+    constexpr uint16_t MAKCU_USB_VID = 0x1A86;
+    constexpr uint16_t MAKCU_USB_PID = 0x55D3;
+
+    // Cross-thread wakeup: eventfd on Linux, self-pipe on other POSIX systems,
+    // auto-reset event on Windows
+    class WakeSignal {
+    public:
+        WakeSignal() = default;
+        ~WakeSignal() { destroy(); }
+
+        bool create();
+        void destroy();
+        void signal();
+        void drain();
+
+#ifdef _WIN32
+        HANDLE handle() const { return m_event; }
+#else
+        int fd() const { return m_fds[0]; }
+#endif
+
+    private:
+#ifdef _WIN32
+        HANDLE m_event = nullptr;
+#else
+        int m_fds[2] = { -1, -1 };
+#endif
+
+        WakeSignal(const WakeSignal&) = delete;
+        WakeSignal& operator=(const WakeSignal&) = delete;
+    };
+
+    // One-shot timer on an absolute steady_clock deadline: timerfd on Linux,
+    // high-resolution waitable timer on Windows, poll() timeout elsewhere
+    class DeadlineTimer {
+    public:
+        using TimePoint = std::chrono::steady_clock::time_point;
+
+        DeadlineTimer() = default;
+        ~DeadlineTimer() { destroy(); }
+
+        bool create();
+        void destroy();
+
+        // Block until wake is signalled or the deadline (TimePoint::max() = none) passes
+        void wait(WakeSignal& wake, TimePoint deadline);
+
+    private:
+#ifdef _WIN32
+        HANDLE m_timer = nullptr;
+#else
+        int m_fd = -1;
+#endif
+
+        DeadlineTimer(const DeadlineTimer&) = delete;
+        DeadlineTimer& operator=(const DeadlineTimer&) = delete;
+    };
+
+    // Minimal io_uring transport for one serial fd (Linux 5.6+, raw
+    // syscalls). A read stays armed; writes are copied into a staging buffer
+    // with at most one in flight, since overlapping tty writes can run on
+    // different io-wq workers and reorder. Bytes queued meanwhile go out as
+    // one coalesced submission. Under SQPOLL submitting is a ring store
+    class IoUring {
+    public:
+        IoUring() = default;
+        ~IoUring();  // destroy(); a ring the kernel still holds goes to retire()
+
+        // Setup plus READ/WRITE/ASYNC_CANCEL support, probed once per process
+        static bool available();
+
+        // sqPoll asks for a kernel submission thread; without it, or if the
+        // kernel refuses, every submission is an io_uring_enter()
+        bool create(int fd, size_t readSize, bool sqPoll = true);
+
+        // Flush queued writes, cancel the armed read (and, after the timeout,
+        // a stuck write) and unmap. False if the kernel still owns a buffer
+        // after a second timeout; the ring is then left intact. The thread
+        // that reaps completions must have stopped
+        bool destroy(std::chrono::milliseconds timeout = std::chrono::milliseconds(100));
+
+        // destroy() that never blocks past the timeouts: a ring that cannot
+        // be released yet is finished on a detached thread
+        static void retire(std::unique_ptr<IoUring> ring,
+            std::chrono::milliseconds timeout = std::chrono::milliseconds(100));
+
+        int fd() const { return m_ringFd; }  // POLLIN while completions are queued
+        bool sqPolling() const { return m_sqPoll; }
+        bool hasCompletions() const;
+
+        bool armRead();
+        bool write(const char* data, size_t length, std::chrono::milliseconds timeout);
+        bool waitWritesIdle(std::chrono::milliseconds timeout);
+
+        // Consume completions, handing read data to onRead and re-arming the
+        // read. False once the read failed (hangup, I/O error)
+        bool reap(const std::function<void(const uint8_t*, size_t)>& onRead);
+
+    private:
+        struct Completion {
+            uint64_t tag;
+            int32_t result;
+        };
+
+        bool mapRings(const void* params);
+        void* nextSqe();
+        void commitSqe();
+        bool submitLocked();
+        bool submitCancelLocked(uint64_t target);
+        bool submitWriteLocked();
+        void completeWriteLocked(int32_t result);
+        size_t takeCompletions(Completion* out, size_t max);
+        void takeOver(IoUring& other);  // Move ring and buffers, leaving other empty
+
+        int m_fd = -1;
+        int m_ringFd = -1;
+        bool m_sqPoll = false;
+
+        void* m_sqRing = nullptr;
+        void* m_cqRing = nullptr;
+        void* m_sqes = nullptr;
+        size_t m_sqRingSize = 0;
+        size_t m_cqRingSize = 0;
+        size_t m_sqesSize = 0;
+        unsigned* m_sqHead = nullptr;
+        unsigned* m_sqTail = nullptr;
+        unsigned* m_sqFlags = nullptr;
+        unsigned* m_sqArray = nullptr;
+        unsigned m_sqMask = 0;
+        unsigned m_sqEntries = 0;
+        unsigned* m_cqHead = nullptr;
+        unsigned* m_cqTail = nullptr;
+        unsigned m_cqMask = 0;
+        void* m_cqes = nullptr;
+        unsigned m_toSubmit = 0;
+
+        std::mutex m_mutex;  // SQ and write state
+        std::condition_variable m_writeDone;
+        std::vector<uint8_t> m_readBuffer;
+        bool m_readArmed = false;
+        std::vector<char> m_inFlight;
+        size_t m_inFlightOffset = 0;
+        bool m_writeInFlight = false;
+        std::vector<char> m_pending;
+        bool m_writeFailed = false;
+
+        IoUring(const IoUring&) = delete;
+        IoUring& operator=(const IoUring&) = delete;
+    };
+
+    // Wire encoding of the hot commands. ASCII is always understood; the
+    // binary encoder reuses the BAUD_CHANGE_COMMAND frame layout
+    // (DE AD, u16 LE length of opcode + payload, opcode, payload)
+    class CommandEncoder {
+    public:
+        virtual ~CommandEncoder() = default;
+
+        virtual WireProtocol protocol() const = 0;
+        virtual void appendMove(std::vector<char>& out, int32_t dx, int32_t dy) const = 0;
+        virtual void appendWheel(std::vector<char>& out, int32_t delta) const = 0;
+        // False (nothing appended) for values outside MouseButton
+        virtual bool appendButton(std::vector<char>& out, MouseButton button, bool pressed) const = 0;
+
+        static const CommandEncoder& forProtocol(WireProtocol protocol);
+
+        // ASCII formatting with std::to_chars into a caller buffer of at least
+        // MAX_TEXT_COMMAND bytes; returns the length including CRLF.
+        // km.move(x,y[,segments[,cx,cy]])\r\n and km.wheel(d)\r\n
+        static constexpr size_t MAX_TEXT_COMMAND = 80;
+        static size_t formatMove(char* out, int32_t dx, int32_t dy);
+        static size_t formatMove(char* out, int32_t dx, int32_t dy, uint32_t segments);
+        static size_t formatMove(char* out, int32_t dx, int32_t dy, uint32_t segments, int32_t cx, int32_t cy);
+        static size_t formatWheel(char* out, int32_t delta);
+    };
+
+    // One command waiting for the writer thread. Relative moves and wheel
+    // deltas stay typed so the writer can merge a backlog of them.
+    struct OutboundCommand {
+        static constexpr size_t INLINE_CAPACITY = 64;
+
+        enum class Kind : uint8_t { Raw, Move, Wheel };
+
+        std::chrono::steady_clock::time_point enqueued;
+        Kind kind = Kind::Raw;
+        CommandPriority priority = CommandPriority::QUERY;
+        int32_t x = 0;  // Move dx / wheel delta
+        int32_t y = 0;  // Move dy
+        uint32_t length = 0;
+        char bytes[INLINE_CAPACITY];
+        std::string overflow;  // Only used for commands longer than INLINE_CAPACITY
+
+        const char* data() const { return length <= INLINE_CAPACITY ? bytes : overflow.data(); }
+
+        void assign(const char* source, size_t count) {
+            kind = Kind::Raw;
+            length = static_cast<uint32_t>(count);
+            if (count <= INLINE_CAPACITY) {
+                memcpy(bytes, source, count);
+            }
+            else {
+                overflow.assign(source, count);
+            }
+        }
+
+        void assignDelta(Kind deltaKind, int32_t first, int32_t second) {
+            kind = deltaKind;
+            x = first;
+            y = second;
+            length = 0;
+        }
+    };
+
+    // Bounded lock-free multi-producer/single-consumer ring (Vyukov sequence cells).
+    // Producers never allocate for commands that fit inline.
+    class CommandQueue {
+    public:
+        static constexpr size_t CAPACITY = 1024;
+
+        CommandQueue();
+
+        // Claim a cell, let fill() populate it, then publish it to the consumer
+        template<typename Fill>
+        bool tryPush(Fill&& fill) {
+            Cell* cell;
+            size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+            while (true) {
+                cell = &m_cells[pos & (CAPACITY - 1)];
+                size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+                if (diff == 0) {
+                    if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                }
+                else if (diff < 0) {
+                    return false; // Full
+                }
+                else {
+                    pos = m_enqueuePos.load(std::memory_order_relaxed);
+                }
+            }
+
+            cell->command.enqueued = std::chrono::steady_clock::now();
+            fill(cell->command);
+            cell->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer side: peek at the oldest ready command, then release it
+        OutboundCommand* front();
+        void pop();
+
+        bool empty() const;
+
+    private:
+        struct Cell {
+            std::atomic<size_t> sequence;
+            OutboundCommand command;
+        };
+
+        std::array<Cell, CAPACITY> m_cells;
+        alignas(64) std::atomic<size_t> m_enqueuePos{ 0 };
+        alignas(64) size_t m_dequeuePos = 0;
+    };
+
+    // One in-flight tracked command. Synchronous queries wait on the slot
+    // itself (result buffer, mutex and condition variable are reused), so
+    // completion allocates nothing; only sendTrackedCommand engages the promise
     struct PendingCommand {
-        int command_id;
-        std::string command;
-        std::promise<std::string> promise;
+        enum Status : uint32_t { Pending, Ready, Failed };
+
+        int command_id = 0;             // 0 while the slot is free
+        std::atomic<uint32_t> status{ Pending };
+        bool has_promise = false;
+        std::optional<std::promise<std::string>> promise;
+        std::string result;
+        std::mutex mutex;
+        std::condition_variable done;
         std::chrono::steady_clock::time_point timestamp;
-        bool expect_response;
-        std::chrono::milliseconds timeout;
+        bool expect_response = false;
+        std::string_view untagged_match;   // Non-empty: untagged replies must contain it
+        std::chrono::milliseconds timeout{ 0 };
+    };
+
+    // Fixed-capacity table of in-flight tracked commands (guarded by the
+    // caller's mutex). Ids encode slot index and a per-slot generation, so a
+    // late reply for a recycled slot never completes the wrong command; an
+    // in-flight FIFO in send order resolves replies that carry no id, and a
+    // deadline min-heap drives promise-backed timeouts
+    class PendingCommandTable {
+    public:
+        using TimePoint = std::chrono::steady_clock::time_point;
+        static constexpr size_t CAPACITY = 256;
+
+        PendingCommandTable();
+
+        // Returns nullptr when every slot is in flight
+        PendingCommand* acquire(bool expectResponse, std::chrono::milliseconds timeout, bool withPromise);
+        void release(PendingCommand& command);
+
+        // nullptr for unknown or stale ids and for commands already completed
+        PendingCommand* find(int id);
+        // Oldest command still in flight, for replies without an id
+        PendingCommand* oldest();
 
-        PendingCommand(int id, const std::string& cmd, bool expect_resp, std::chrono::milliseconds to)
-            : command_id(id), command(cmd), expect_response(expect_resp), timeout(to) {
-            timestamp = std::chrono::steady_clock::now();
+        // Next live command whose deadline is <= now (one per call), and the
+        // earliest live deadline (TimePoint::max() if none)
+        PendingCommand* popExpired(TimePoint now);
+        TimePoint nextDeadline();
+
+        size_t size() const { return CAPACITY - m_freeCount; }
+        bool empty() const { return m_freeCount == CAPACITY; }
+
+        template<typename Fn>
+        void forEachActive(Fn&& fn) {
+            for (auto& slot : m_slots) {
+                if (slot.command_id != 0) {
+                    fn(slot);
+                }
+            }
         }
+
+    private:
+        static constexpr uint32_t INDEX_BITS = 8;
+        static constexpr uint32_t MAX_GENERATION = (1u << (31 - INDEX_BITS)) - 1;
+        static constexpr size_t FIFO_CAPACITY = CAPACITY * 2;
+        static constexpr size_t TIMEOUT_CAPACITY = CAPACITY * 2;
+        static_assert((size_t(1) << INDEX_BITS) == CAPACITY, "index bits must cover the table");
+
+        bool isLive(int id) const;
+        void compactFifo();
+        void compactTimeouts();
+
+        std::array<PendingCommand, CAPACITY> m_slots;
+        std::array<uint32_t, CAPACITY> m_generations{};
+        std::array<uint16_t, CAPACITY> m_freeList{};
+        size_t m_freeCount = CAPACITY;
+        std::array<int, FIFO_CAPACITY> m_fifo{};
+        size_t m_fifoHead = 0;
+        size_t m_fifoTail = 0;
+
+        // Min-heap on deadline; entries for completed commands are dropped lazily
+        struct TimeoutEntry {
+            TimePoint deadline;
+            int id;
+            bool operator>(const TimeoutEntry& other) const { return deadline > other.deadline; }
+        };
+        std::array<TimeoutEntry, TIMEOUT_CAPACITY> m_timeouts{};
+        size_t m_timeoutCount = 0;
     };
 
     class SerialPort {
@@ -48,8 +396,111 @@ namespace makcu {
             bool expectResponse = false,
             std::chrono::milliseconds timeout = std::chrono::milliseconds(100));
 
-        // Fast fire-and-forget commands
-        bool sendCommand(const std::string& command);
+        // Blocking query on a pooled slot (no promise/future allocation);
+        // false on timeout, write failure or close. A reply carrying the
+        // query's id always completes it; with untaggedMatch set, a line
+        // without an id only does if it contains untaggedMatch (others are
+        // dropped, e.g. line noise after a baud switch)
+        bool query(const std::string& command, std::string& response,
+            std::chrono::milliseconds timeout = std::chrono::milliseconds(100),
+            std::string_view untaggedMatch = {});
+
+        // Busy-wait this long for a query reply before parking (default 0)
+        void setQuerySpinTime(std::chrono::microseconds spin);
+        std::chrono::microseconds getQuerySpinTime() const;
+
+        // Fast fire-and-forget commands (CRLF appended on the stack)
+        bool sendCommand(std::string_view command);
+
+        // Relative deltas; with the writer thread enabled a backlog of
+        // adjacent moves (or wheel steps) is merged into one command
+        bool sendMove(int32_t dx, int32_t dy);
+        bool sendWheel(int32_t delta);
+        bool sendButton(MouseButton button, bool pressed);
+
+        // Bytes already encoded in the current wire protocol, sent as one write
+        bool sendEncoded(const char* data, size_t length, CommandPriority priority);
+
+        // Firmware-interpolated moves (ASCII only), formatted on the stack
+        bool sendSmoothMove(int32_t dx, int32_t dy, uint32_t segments);
+        bool sendBezierMove(int32_t dx, int32_t dy, uint32_t segments, int32_t cx, int32_t cy);
+
+        // Encoder for move/wheel/button commands (default ASCII). Only switch
+        // to BINARY after the firmware acknowledged it
+        void setWireProtocol(WireProtocol protocol);
+        WireProtocol getWireProtocol() const;
+
+        // Opt-in writer thread: commands are queued and coalesced into one
+        // write per wakeup instead of being written on the caller's thread
+        void setWriterThreadEnabled(bool enable);
+        bool isWriterThreadEnabled() const;
+        WriterStats getWriterStats() const;
+
+        // Timer scheduler: each step is submitted at its absolute deadline by an
+        // internal thread (started on first use); steps with equal deadlines
+        // fire in the order given. Buttons pressed by fired steps are released
+        // when the action is cancelled or the port closes first
+        using ScheduleStep = std::pair<std::chrono::steady_clock::time_point, std::string>;
+        ScheduledAction schedule(const std::vector<ScheduleStep>& steps);
+
+        // Slices of a shared, already encoded buffer, each submitted at
+        // start + offset in its class; the bytes are referenced, not copied.
+        // presses/releases: buttons (bit = MouseButton) the slot leaves
+        // pressed/released, for cancel(); held: pressed before the first slot
+        struct EncodedSlot {
+            std::chrono::nanoseconds offset;
+            uint32_t begin;
+            uint32_t length;
+            CommandPriority priority;
+            uint8_t presses = 0;
+            uint8_t releases = 0;
+        };
+        ScheduledAction scheduleEncoded(std::chrono::steady_clock::time_point start,
+            std::shared_ptr<const std::vector<char>> bytes, const EncodedSlot* slots, size_t count,
+            uint8_t held = 0);
+        ScheduleStats getScheduleStats() const;
+
+        ReceiveStats getReceiveStats() const;
+
+        // After each received burst the listener keeps reading for this long
+        // before blocking again, catching replies to pipelined commands
+        // without a wakeup. 0 (default) always blocks
+        void setReceiveSpinTime(std::chrono::microseconds spin);
+        std::chrono::microseconds getReceiveSpinTime() const;
+
+        // Transport for the next open(): io_uring (Linux) or read/write with
+        // poll(). Falls back to poll() if the ring cannot be set up; false if
+        // io_uring is unavailable on this system. sqPoll: see IoUring::create
+        bool setIoBackend(IoBackend backend, bool sqPoll = true);
+        IoBackend getIoBackend() const;  // Active backend while open
+        bool isSqPolling() const;        // Open on a ring with SQPOLL engaged
+
+        // Real-time mode for the listener, writer and scheduler threads: CPU
+        // pinning, SCHED_FIFO, mlockall with prefaulted stacks/buffers and
+        // ASYNC_LOW_LATENCY on the tty. Threads adopt it at their next wakeup.
+        // False if the memory lock or tty flag was refused
+        bool setRealtimeMode(const RealtimeConfig& config);
+        RealtimeConfig getRealtimeMode() const;
+        RealtimeStatus getRealtimeStatus() const;
+
+        // Merge queued moves/wheel deltas when the writer falls behind (default on)
+        void setCoalescingEnabled(bool enable);
+        bool isCoalescingEnabled() const;
+
+        // Release at most one aggregated move/wheel per tick on a fixed grid
+        // (e.g. 1000us for 1 kHz, 125us for 8 kHz); zero disables pacing.
+        // Enabling pacing starts the writer thread.
+        void setPacingInterval(std::chrono::microseconds interval);
+        std::chrono::microseconds getPacingInterval() const;
+
+        // One writer queue per CommandPriority, drained highest class first
+        // (FIFO within a class); a class whose oldest command waited past the
+        // starvation limit is drained first instead. Off: a single FIFO.
+        // Enabling starts the writer thread; switching drains what is queued
+        void setPriorityClassesEnabled(bool enable);
+        bool isPriorityClassesEnabled() const;
+        void setStarvationLimit(std::chrono::microseconds limit);
+        std::chrono::microseconds getStarvationLimit() const;
 
         // Legacy methods for compatibility
         bool write(const std::vector<uint8_t>& data);
@@ -66,12 +517,33 @@ namespace makcu {
 
         // Port enumeration
         static std::vector<std::string> getAvailablePorts();
+
+        // Cached; on Linux the cache is dropped whenever inotify reports a
+        // node created/removed in /dev, so repeated connects don't rescan
         static std::vector<std::string> findMakcuPorts();
+        static void invalidatePortCache();
+
+        // Uncached Linux scan of <sysfsRoot>/class/tty (a fake tree in tests);
+        // returns /dev/<name> for every tty on a matching USB device
+        static std::vector<std::string> findMakcuPorts(const std::string& sysfsRoot);
+
+        // Linux: sysfs root and hotplug directory used by the cached scan
+        // ("/sys" and "/dev"; a fake tree in tests). Drops the cached result
+        static void setPortDiscoveryRoots(const std::string& sysfsRoot, const std::string& watchDir);
 
         // Button callback support
         using ButtonCallback = std::function<void(uint8_t, bool)>;
         void setButtonCallback(ButtonCallback callback);
 
+        // Run bytes through the receive parser as if the listener had read
+        // them (replaying captured traffic, benchmarks). Ignored while open
+        void feedReceived(const uint8_t* data, size_t length);
+
+        // Invoked once from the listener thread on EOF, hangup or a read
+        // error (USB unplug); the listener then exits and the owner recovers
+        using DisconnectCallback = std::function<void()>;
+        void setDisconnectCallback(DisconnectCallback callback);
+
     private:
         std::string m_portName;
         uint32_t m_baudRate;
@@ -83,35 +555,166 @@ namespace makcu {
         HANDLE m_handle;
         DCB m_dcb;
         COMMTIMEOUTS m_timeouts;
+        HANDLE m_writeEvent;  // Completion event for overlapped writes
 #else
         int m_fd;
 #endif
+        std::mutex m_writeMutex;
+        std::atomic<IoBackend> m_ioBackend{ IoBackend::POLL };
+        std::atomic<bool> m_uringSqPoll{ true };
+        std::unique_ptr<IoUring> m_uring;  // Set by open() when the io_uring backend is active
+        WakeSignal m_listenerWake;  // Signalled by close() to interrupt the listener wait
 
         // Command tracking system
-        std::atomic<int> m_commandCounter{ 0 };
-        std::unordered_map<int, std::unique_ptr<PendingCommand>> m_pendingCommands;
+        PendingCommandTable m_pendingCommands;
         std::mutex m_commandMutex;
+        std::atomic<int64_t> m_querySpinNs{ 0 };
+        // Expiry the listener is currently sleeping towards (m_commandMutex)
+        std::chrono::steady_clock::time_point m_listenerDeadline = (std::chrono::steady_clock::time_point::max)();
 
         // High-performance listener thread
         std::thread m_listenerThread;
         std::atomic<bool> m_stopListener{ false };
 
+        // Outbound writer thread; with priority classes off every command
+        // goes through m_outbound[0]
+        std::array<CommandQueue, COMMAND_PRIORITY_COUNT> m_outbound;
+        std::atomic<bool> m_priorityClasses{ false };
+        std::atomic<int64_t> m_starvationLimitNs{ 2000000 };
+        WakeSignal m_writerWake;
+        std::thread m_writerThread;
+        std::atomic<bool> m_writerEnabled{ false };
+        std::atomic<bool> m_writerRunning{ false };
+        std::atomic<bool> m_stopWriter{ false };
+        std::atomic<bool> m_writerIdle{ false };
+        std::atomic<uint32_t> m_producersInFlight{ 0 };  // Inside enqueue(); see stopWriter()
+        std::atomic<bool> m_coalescing{ true };
+        std::atomic<int64_t> m_pacingIntervalNs{ 0 };
+        DeadlineTimer m_pacingTimer;
+        std::vector<char> m_writeStaging;
+        uint32_t m_classesServed = 0;  // Writer-owned: bit per class written by the last drain
+
+        // Writer counters (written by the writer thread, read by anyone)
+        std::atomic<uint64_t> m_statQueued{ 0 };
+        std::atomic<uint64_t> m_statWritten{ 0 };
+        std::atomic<uint64_t> m_statSyscalls{ 0 };
+        std::atomic<uint64_t> m_statWriteErrors{ 0 };
+        std::atomic<uint64_t> m_statQueueFull{ 0 };
+        std::atomic<uint64_t> m_statLatencyNs{ 0 };
+        std::atomic<uint64_t> m_statMaxLatencyNs{ 0 };
+        std::atomic<uint64_t> m_statMovesMerged{ 0 };
+        std::atomic<uint64_t> m_statWheelsMerged{ 0 };
+        std::atomic<uint64_t> m_statPacedTicks{ 0 };
+        std::atomic<uint64_t> m_statPacingJitterNs{ 0 };
+        std::atomic<uint64_t> m_statMaxPacingJitterNs{ 0 };
+        std::atomic<uint64_t> m_statBytesWritten{ 0 };
+        std::atomic<uint64_t> m_statClassCommands[COMMAND_PRIORITY_COUNT]{};
+        std::atomic<uint64_t> m_statClassDelayNs[COMMAND_PRIORITY_COUNT]{};
+        std::atomic<uint64_t> m_statClassMaxDelayNs[COMMAND_PRIORITY_COUNT]{};
+        std::atomic<uint64_t> m_statClassPromotions[COMMAND_PRIORITY_COUNT]{};
+        std::atomic<const CommandEncoder*> m_encoder{ &CommandEncoder::forProtocol(WireProtocol::ASCII) };
+
+        // Timer scheduler (min-heap on deadline, sequence breaks ties)
+        struct ScheduledCommand {
+            std::chrono::steady_clock::time_point deadline;
+            uint64_t sequence;
+            std::string command;                               // schedule(): owned text
+            std::shared_ptr<const std::vector<char>> encoded;  // scheduleEncoded(): shared bytes
+            uint32_t begin = 0;
+            uint32_t length = 0;
+            CommandPriority priority = CommandPriority::QUERY;
+            std::shared_ptr<ScheduledAction::State> state;
+            uint8_t presses = 0;                               // See EncodedSlot
+            uint8_t releases = 0;
+
+            const char* data() const { return encoded ? encoded->data() + begin : command.data(); }
+            size_t size() const { return encoded ? length : command.size(); }
+
+            bool operator>(const ScheduledCommand& other) const {
+                return deadline != other.deadline ? deadline > other.deadline : sequence > other.sequence;
+            }
+        };
+        std::priority_queue<ScheduledCommand, std::vector<ScheduledCommand>,
+            std::greater<ScheduledCommand>> m_schedule;
+        std::mutex m_scheduleMutex;
+        uint64_t m_scheduleSequence = 0;
+        std::thread m_schedulerThread;
+        WakeSignal m_schedulerWake;
+        DeadlineTimer m_schedulerTimer;
+        std::atomic<bool> m_stopScheduler{ false };
+        std::atomic<uint64_t> m_statScheduledFired{ 0 };
+        std::atomic<uint64_t> m_statScheduledCancelled{ 0 };
+        std::atomic<uint64_t> m_statScheduleLatenessNs{ 0 };
+        std::atomic<uint64_t> m_statMaxScheduleLatenessNs{ 0 };
+
         // Button data processing
         ButtonCallback m_buttonCallback;
+        DisconnectCallback m_disconnectCallback;
+
+        // Real-time mode: config under m_realtimeMutex, each thread re-applies
+        // it to itself when the generation changes
+        enum class ThreadRole { Listener, Writer, Scheduler };
+        mutable std::mutex m_realtimeMutex;
+        RealtimeConfig m_realtime;
+        std::atomic<uint32_t> m_realtimeGeneration{ 0 };
+        std::atomic<bool> m_rtAffinity{ false };
+        std::atomic<bool> m_rtPriority{ false };
+        std::atomic<bool> m_rtMemoryLocked{ false };
+        std::atomic<bool> m_rtLowLatency{ false };
         std::atomic<uint8_t> m_lastButtonMask{ 0 };
 
         // Optimized parsing buffers
         static constexpr size_t BUFFER_SIZE = 4096;
-        static constexpr size_t LINE_BUFFER_SIZE = 256;
+        static constexpr size_t LINE_ARENA_INITIAL = 256;
+        static constexpr size_t LINE_ARENA_LIMIT = 64 * 1024;  // Longer lines are dropped
+
+        // Incremental line assembly (owned by the listener thread). Lines that
+        // span reads spill into the arena, which grows on demand and is reused
+        std::vector<char> m_lineArena;
+        size_t m_linePos = 0;
+        bool m_lineOverflow = false;
+        std::atomic<uint64_t> m_statLinesZeroCopy{ 0 };
+        std::atomic<uint64_t> m_statLinesAssembled{ 0 };
+        std::atomic<uint64_t> m_statLinesDropped{ 0 };
+        std::atomic<uint64_t> m_statLongestLine{ 0 };
+        std::atomic<uint64_t> m_statArenaCapacity{ 0 };
+
+        // Receive spin window (0 = always block) and its counters
+        std::atomic<int64_t> m_receiveSpinNs{ 0 };
+        std::atomic<uint64_t> m_statSpinHits{ 0 };
+        std::atomic<uint64_t> m_statSpinTimeouts{ 0 };
+        std::atomic<uint64_t> m_statParks{ 0 };
+        std::atomic<uint64_t> m_statSpinNs{ 0 };
 
         bool configurePort();
         void updateTimeouts();
+        bool writeAll(const char* data, size_t length);
+        bool writeAllLocked(const char* data, size_t length);
+        bool submit(const char* data, size_t length, CommandPriority priority);
+        template<typename Fill>
+        bool enqueue(CommandPriority priority, Fill&& fill);
+        bool outboundEmpty() const;
+        void startWriter();
+        void stopWriter();
+        void setWriterThreadEnabledLocked(bool enable);
+        void writerLoop();
+        bool startSchedulerLocked();  // Caller holds m_scheduleMutex
+        void armReleaseHeld(ScheduledAction::State& state);
+        void stopScheduler();
+        void schedulerLoop();
+        bool drainOutbound(size_t deltaRunsAllowed, bool& deltaReleased);
         void listenerLoop();
-        void processIncomingData();
+        void handleConnectionLost();
+        bool startIoUring();
+        uint32_t applyRealtime(ThreadRole role);
+        bool setLowLatency(bool enable);
+        void processIncomingData(const uint8_t* data, size_t length);
         void handleButtonData(uint8_t data);
-        void processResponse(const std::string& response);
-        void cleanupTimedOutCommands();
-        int generateCommandId();
+        void appendLine(const char* data, size_t length);
+        void processResponse(std::string_view response);
+        void completeCommand(PendingCommand& command, std::string_view result);
+        void failCommand(PendingCommand& command, const char* reason);
+        std::chrono::steady_clock::time_point expireTimedOutCommands();
 
         // Disable copy
         SerialPort(const SerialPort&) = delete;
@@ -179,8 +179,9 @@ void lockingDemo() {
     // Show all lock states
     std::cout << "3. Current lock states:\n";
     auto lockStates = device.getAllLockStates();
-    for (const auto& [name, locked] : lockStates) {
-        std::cout << "   " << name << ": " << (locked ? "LOCKED" : "UNLOCKED") << "\n";
+    for (makcu::LockTarget target : makcu::ALL_LOCK_TARGETS) {
+        std::cout << "   " << makcu::lockTargetName(target) << ": "
+                  << (lockStates.isLocked(target) ? "LOCKED" : "UNLOCKED") << "\n";
     }
 
     device.disconnect();
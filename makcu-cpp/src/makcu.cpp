@@ -8,18 +8,60 @@
 #include <cctype>
 #include <atomic>
 #include <mutex>
+#include <condition_variable>
 #include <unordered_map>
+#include <charconv>
+#include <cmath>
+#include <deque>
+#include <type_traits>
 
 namespace makcu {
 
     // Constants
-    constexpr uint16_t MAKCU_VID = 0x1A86;
-    constexpr uint16_t MAKCU_PID = 0x55D3;
     constexpr const char* TARGET_DESC = "USB-Enhanced-SERIAL CH343";
     constexpr const char* DEFAULT_NAME = "USB-SERIAL CH340";
     constexpr uint32_t INITIAL_BAUD_RATE = 115200;
     constexpr uint32_t HIGH_SPEED_BAUD_RATE = 4000000;
 
+    // Readiness probe: km.version() is retried on this interval until the
+    // device answers at the new rate or the budget runs out
+    constexpr auto READY_PROBE_INTERVAL = std::chrono::milliseconds(5);
+    constexpr auto READY_PROBE_BUDGET = std::chrono::milliseconds(500);
+    constexpr auto FAST_PATH_PROBE_BUDGET = std::chrono::milliseconds(10);
+    constexpr std::string_view VERSION_MARKER = "km.MAKCU";  // In every km.version() reply
+
+    // Auto-reconnect backoff between failed reopen attempts
+    constexpr auto RECONNECT_BACKOFF_MIN = std::chrono::milliseconds(2);
+    constexpr auto RECONNECT_BACKOFF_MAX = std::chrono::milliseconds(250);
+
+    // Pre-built commands, indexed by MouseButton / LockTarget
+    constexpr std::array<std::string_view, 5> PRESS_COMMANDS = {
+        "km.left(1)", "km.right(1)", "km.middle(1)", "km.ms1(1)", "km.ms2(1)"
+    };
+    constexpr std::array<std::string_view, 5> RELEASE_COMMANDS = {
+        "km.left(0)", "km.right(0)", "km.middle(0)", "km.ms1(0)", "km.ms2(0)"
+    };
+    constexpr std::array<std::string_view, LOCK_TARGET_COUNT> LOCK_COMMANDS = {
+        "km.lock_mx(1)", "km.lock_my(1)", "km.lock_ml(1)", "km.lock_mr(1)",
+        "km.lock_mm(1)", "km.lock_ms1(1)", "km.lock_ms2(1)"
+    };
+    constexpr std::array<std::string_view, LOCK_TARGET_COUNT> UNLOCK_COMMANDS = {
+        "km.lock_mx(0)", "km.lock_my(0)", "km.lock_ml(0)", "km.lock_mr(0)",
+        "km.lock_mm(0)", "km.lock_ms1(0)", "km.lock_ms2(0)"
+    };
+    constexpr std::array<std::string_view, LOCK_TARGET_COUNT> LOCK_TARGET_NAMES = {
+        "X", "Y", "LEFT", "RIGHT", "MIDDLE", "SIDE1", "SIDE2"
+    };
+
+    // Empty for values outside MouseButton
+    constexpr std::string_view buttonCommand(MouseButton button, bool pressed) {
+        size_t index = static_cast<size_t>(button);
+        if (index >= PRESS_COMMANDS.size()) {
+            return {};
+        }
+        return pressed ? PRESS_COMMANDS[index] : RELEASE_COMMANDS[index];
+    }
+
     // Baud rate change command
     const std::vector<uint8_t> BAUD_CHANGE_COMMAND = {
         0xDE, 0xAD, 0x05, 0x00, 0xA5, 0x00, 0x09, 0x3D, 0x00
@@ -30,56 +72,163 @@ namespace makcu {
     std::mutex PerformanceProfiler::s_mutex;
     std::unordered_map<std::string, std::pair<uint64_t, uint64_t>> PerformanceProfiler::s_stats;
 
-    // Command cache for maximum performance
-    struct CommandCache {
-        // Pre-computed command strings
-        std::unordered_map<MouseButton, std::string> press_commands;
-        std::unordered_map<MouseButton, std::string> release_commands;
-        std::unordered_map<std::string, std::string> lock_commands;
-        std::unordered_map<std::string, std::string> unlock_commands;
-        std::unordered_map<std::string, std::string> query_commands;
-
-        CommandCache() {
-            // Pre-compute all button commands
-            press_commands[MouseButton::LEFT] = "km.left(1)";
-            press_commands[MouseButton::RIGHT] = "km.right(1)";
-            press_commands[MouseButton::MIDDLE] = "km.middle(1)";
-            press_commands[MouseButton::SIDE1] = "km.ms1(1)";
-            press_commands[MouseButton::SIDE2] = "km.ms2(1)";
-
-            release_commands[MouseButton::LEFT] = "km.left(0)";
-            release_commands[MouseButton::RIGHT] = "km.right(0)";
-            release_commands[MouseButton::MIDDLE] = "km.middle(0)";
-            release_commands[MouseButton::SIDE1] = "km.ms1(0)";
-            release_commands[MouseButton::SIDE2] = "km.ms2(0)";
-
-            // Pre-compute lock commands
-            lock_commands["X"] = "km.lock_mx(1)";
-            lock_commands["Y"] = "km.lock_my(1)";
-            lock_commands["LEFT"] = "km.lock_ml(1)";
-            lock_commands["RIGHT"] = "km.lock_mr(1)";
-            lock_commands["MIDDLE"] = "km.lock_mm(1)";
-            lock_commands["SIDE1"] = "km.lock_ms1(1)";
-            lock_commands["SIDE2"] = "km.lock_ms2(1)";
-
-            unlock_commands["X"] = "km.lock_mx(0)";
-            unlock_commands["Y"] = "km.lock_my(0)";
-            unlock_commands["LEFT"] = "km.lock_ml(0)";
-            unlock_commands["RIGHT"] = "km.lock_mr(0)";
-            unlock_commands["MIDDLE"] = "km.lock_mm(0)";
-            unlock_commands["SIDE1"] = "km.lock_ms1(0)";
-            unlock_commands["SIDE2"] = "km.lock_ms2(0)";
-
-            query_commands["X"] = "km.lock_mx()";
-            query_commands["Y"] = "km.lock_my()";
-            query_commands["LEFT"] = "km.lock_ml()";
-            query_commands["RIGHT"] = "km.lock_mr()";
-            query_commands["MIDDLE"] = "km.lock_mm()";
-            query_commands["SIDE1"] = "km.lock_ms1()";
-            query_commands["SIDE2"] = "km.lock_ms2()";
+    // User callback that may be replaced while the listener or supervisor
+    // thread is calling it; a caller keeps its copy alive for the call
+    template<typename Fn>
+    class CallbackSlot {
+    public:
+        void set(Fn fn) {
+            auto next = fn ? std::make_shared<const Fn>(std::move(fn)) : nullptr;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_fn.swap(next);
+        }
+
+        std::shared_ptr<const Fn> get() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_fn;
         }
+
+    private:
+        mutable std::mutex m_mutex;
+        std::shared_ptr<const Fn> m_fn;
     };
 
+    // Fixed worker set for the *Async methods that block (connect, disconnect,
+    // queries). State and workers are created on first use; shutdown() runs
+    // what is queued, then joins them. State is shared so a worker that
+    // shutdown() had to detach (called from a job) can still exit cleanly
+    class AsyncExecutor {
+    public:
+        static constexpr size_t WORKERS = 2;
+
+        ~AsyncExecutor() { shutdown(); }
+
+        template<typename F>
+        auto submit(F fn) -> std::future<decltype(fn())> {
+            using Result = decltype(fn());
+            auto job = std::make_unique<TaskJob<F, Result>>(std::move(fn));
+            auto future = job->promise.get_future();
+
+            std::shared_ptr<State> state;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_stopped) {
+                    if (!m_state) {
+                        m_state = std::make_shared<State>();
+                        for (size_t i = 0; i < WORKERS; ++i) {
+                            m_workers.emplace_back(&AsyncExecutor::workerLoop, m_state);
+                        }
+                    }
+                    state = m_state;
+                }
+            }
+            if (!state) {
+                job->run();  // Shut down: run on the caller
+                return future;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->jobs.push_back(std::move(job));
+            }
+            state->wake.notify_one();
+            return future;
+        }
+
+        void shutdown() {
+            std::shared_ptr<State> state;
+            std::vector<std::thread> workers;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stopped = true;
+                state = m_state;
+                workers.swap(m_workers);
+            }
+            if (!state) {
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->stopping = true;
+            }
+            state->wake.notify_all();
+            for (auto& worker : workers) {
+                if (worker.get_id() == std::this_thread::get_id()) {
+                    worker.detach();
+                }
+                else {
+                    worker.join();
+                }
+            }
+        }
+
+    private:
+        struct Job {
+            virtual ~Job() = default;
+            virtual void run() = 0;
+        };
+
+        template<typename F, typename Result>
+        struct TaskJob final : Job {
+            explicit TaskJob(F function) : fn(std::move(function)) {}
+
+            void run() override {
+                try {
+                    if constexpr (std::is_void_v<Result>) {
+                        fn();
+                        promise.set_value();
+                    }
+                    else {
+                        promise.set_value(fn());
+                    }
+                }
+                catch (...) {
+                    promise.set_exception(std::current_exception());
+                }
+            }
+
+            F fn;
+            std::promise<Result> promise;
+        };
+
+        struct State {
+            std::mutex mutex;
+            std::condition_variable wake;
+            std::deque<std::unique_ptr<Job>> jobs;
+            bool stopping = false;
+        };
+
+        static void workerLoop(std::shared_ptr<State> state) {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            while (true) {
+                state->wake.wait(lock, [&] { return state->stopping || !state->jobs.empty(); });
+                if (state->jobs.empty()) {
+                    return;
+                }
+                std::unique_ptr<Job> job = std::move(state->jobs.front());
+                state->jobs.pop_front();
+                lock.unlock();
+                job->run();
+                job.reset();
+                lock.lock();
+            }
+        }
+
+        std::mutex m_mutex;  // Guards the three members below
+        bool m_stopped = false;
+        std::shared_ptr<State> m_state;
+        std::vector<std::thread> m_workers;
+    };
+
+    // Fire-and-forget commands only write or enqueue, so their async forms
+    // run on the caller and return an already satisfied future
+    static std::future<bool> readyFuture(bool value) {
+        std::promise<bool> promise;
+        promise.set_value(value);
+        return promise.get_future();
+    }
+
     // High-performance PIMPL implementation
     class Device::Impl {
     public:
@@ -89,10 +238,11 @@ namespace makcu {
         std::atomic<bool> connected;
         std::atomic<bool> monitoring;
         std::atomic<bool> highPerformanceMode;
+        std::atomic<bool> binaryRequested{ false };
         mutable std::mutex mutex;
 
-        // Command cache for ultra-fast lookups
-        CommandCache commandCache;
+        // Runs the blocking *Async calls
+        AsyncExecutor executor;
 
         // State caching with bitwise operations (like Python v2.0)
         std::atomic<uint16_t> lockStateCache{ 0 };  // 16 bits for different lock states
@@ -102,12 +252,27 @@ namespace makcu {
         std::atomic<uint8_t> currentButtonMask{ 0 };
 
         // Callbacks
-        Device::MouseButtonCallback mouseButtonCallback;
-        Device::ConnectionCallback connectionCallback;
-
-        // Pre-allocated string buffers for move commands
-        mutable std::string moveCommandBuffer;
-        mutable std::mutex moveBufferMutex;
+        CallbackSlot<Device::MouseButtonCallback> mouseButtonCallback;
+        CallbackSlot<Device::ConnectionCallback> connectionCallback;
+        CallbackSlot<Device::ReconnectCallback> reconnectCallback;
+
+        // Connection supervisor: the listener reports a dead port, recovery
+        // runs on this thread so the listener can be joined by close().
+        // Bumping supervisorGeneration retires the running supervisor
+        std::atomic<bool> autoReconnect{ true };
+        bool portDiscovered = false;
+        std::thread supervisorThread;
+        std::mutex supervisorMutex;
+        std::condition_variable supervisorWake;
+        uint64_t supervisorGeneration = 0;
+        bool connectionLost = false;
+        std::chrono::steady_clock::time_point lostAt;
+
+        // Transformed replays are encoded here; the bytes are reused once no
+        // scheduled step references them any more
+        std::mutex replayMutex;
+        std::shared_ptr<std::vector<char>> replayBytes;
+        std::vector<SerialPort::EncodedSlot> replaySlots;
 
         Impl() : serialPort(std::make_unique<SerialPort>())
             , status(ConnectionStatus::DISCONNECTED)
@@ -120,9 +285,14 @@ namespace makcu {
             serialPort->setButtonCallback([this](uint8_t button, bool pressed) {
                 handleButtonEvent(button, pressed);
                 });
+            serialPort->setDisconnectCallback([this]() {
+                onConnectionLost();
+                });
         }
 
-        ~Impl() = default;
+        ~Impl() {
+            stopSupervisor();
+        }
 
         bool switchToHighSpeedMode() {
             if (!serialPort->isOpen()) {
@@ -138,16 +308,54 @@ namespace makcu {
                 return false;
             }
 
-            // Close and reopen at high speed
+            // Close and reopen at high speed; ready once it answers there
             std::string portName = serialPort->getPortName();
             serialPort->close();
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
-
             if (!serialPort->open(portName, HIGH_SPEED_BAUD_RATE)) {
                 return false;
             }
 
+            return probeReady(READY_PROBE_BUDGET);
+        }
+
+        // Poll km.version() until the device answers: either a reply tagged
+        // with the probe's id or, for firmware that does not echo ids, a line
+        // carrying the version string. Stray lines left over from the baud
+        // switch match neither. A write error or a lost reply just waits for
+        // the next interval
+        bool probeReady(std::chrono::milliseconds budget) {
+            auto deadline = std::chrono::steady_clock::now() + budget;
+            std::string response;
+            do {
+                auto attempt = std::chrono::steady_clock::now();
+                if (serialPort->query("km.version()", response, READY_PROBE_INTERVAL, VERSION_MARKER) &&
+                    !response.empty()) {
+                    return true;
+                }
+                std::this_thread::sleep_until(attempt + READY_PROBE_INTERVAL);
+            } while (std::chrono::steady_clock::now() < deadline);
+            return false;
+        }
+
+        // Open the port at 4 Mbaud. A device that is already switched (host
+        // process restarted, link glitch without a device reset) answers
+        // straight away; otherwise fall back to 115200 and the baud change
+        bool openHighSpeed(const std::string& port) {
+            if (serialPort->open(port, HIGH_SPEED_BAUD_RATE)) {
+                if (probeReady(FAST_PATH_PROBE_BUDGET)) {
+                    return true;
+                }
+                serialPort->close();
+            }
+
+            if (!serialPort->open(port, INITIAL_BAUD_RATE)) {
+                return false;
+            }
+            if (!switchToHighSpeedMode()) {
+                serialPort->close();
+                return false;
+            }
             return true;
         }
 
@@ -156,9 +364,6 @@ namespace makcu {
                 return false;
             }
 
-            // Small delay for device to be ready
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-
             // Enable button monitoring - fire and forget for performance
             return serialPort->sendCommand("km.buttons(1)");
         }
@@ -175,10 +380,11 @@ namespace makcu {
             currentButtonMask.store(currentMask);
 
             // Call user callback if set
-            if (mouseButtonCallback && button < 5) {
+            auto callback = button < 5 ? mouseButtonCallback.get() : nullptr;
+            if (callback) {
                 MouseButton mouseBtn = static_cast<MouseButton>(button);
                 try {
-                    mouseButtonCallback(mouseBtn, pressed);
+                    (*callback)(mouseBtn, pressed);
                 }
                 catch (...) {
                     // Ignore callback exceptions
@@ -186,10 +392,173 @@ namespace makcu {
             }
         }
 
+        // Listener thread: hand the failure to the supervisor
+        void onConnectionLost() {
+            {
+                std::lock_guard<std::mutex> lock(supervisorMutex);
+                connectionLost = true;
+                lostAt = std::chrono::steady_clock::now();
+            }
+            supervisorWake.notify_all();
+        }
+
+        // Caller holds mutex
+        void startSupervisor() {
+            std::lock_guard<std::mutex> lock(supervisorMutex);
+            if (supervisorThread.joinable()) {
+                return;
+            }
+            connectionLost = false;
+            supervisorThread = std::thread(&Impl::supervisorLoop, this, supervisorGeneration);
+        }
+
+        void stopSupervisor() {
+            std::thread retired;
+            {
+                std::lock_guard<std::mutex> lock(supervisorMutex);
+                ++supervisorGeneration;
+                connectionLost = false;
+                retired = std::move(supervisorThread);
+            }
+            supervisorWake.notify_all();
+            if (retired.joinable()) {
+                if (retired.get_id() == std::this_thread::get_id()) {
+                    retired.detach();  // disconnect() from a callback on the supervisor
+                }
+                else {
+                    retired.join();
+                }
+            }
+        }
+
+        void supervisorLoop(uint64_t generation) {
+            std::unique_lock<std::mutex> lock(supervisorMutex);
+            while (true) {
+                supervisorWake.wait(lock, [&] {
+                    return supervisorGeneration != generation || connectionLost;
+                    });
+                if (supervisorGeneration != generation) {
+                    return;
+                }
+                connectionLost = false;
+                auto since = lostAt;
+                lock.unlock();
+                recoverConnection(generation, since);
+                lock.lock();
+            }
+        }
+
+        // Close the dead port, then reopen with exponential backoff until the
+        // device answers again or disconnect() retires this supervisor
+        void recoverConnection(uint64_t generation, std::chrono::steady_clock::time_point since) {
+            bool retry = autoReconnect.load();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!connected.load()) {
+                    return;
+                }
+                connected.store(false);
+                status = retry ? ConnectionStatus::CONNECTING : ConnectionStatus::CONNECTION_ERROR;
+                deviceInfo.isConnected = false;
+                currentButtonMask.store(0);
+                serialPort->close();
+            }
+            notifyConnectionChange(false);
+            if (!retry) {
+                return;
+            }
+
+            auto backoff = RECONNECT_BACKOFF_MIN;
+            for (uint32_t attempt = 1;; ++attempt) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!isCurrentSupervisor(generation)) {
+                        return;
+                    }
+                    if (reopen()) {
+                        connected.store(true);
+                        status = ConnectionStatus::CONNECTED;
+                        deviceInfo.isConnected = true;
+                    }
+                    else {
+                        serialPort->close();
+                    }
+                }
+
+                if (connected.load()) {
+                    auto outage = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - since);
+                    notifyConnectionChange(true);
+                    if (auto callback = reconnectCallback.get()) {
+                        try {
+                            (*callback)(outage, attempt);
+                        }
+                        catch (...) {
+                            // Ignore callback exceptions
+                        }
+                    }
+                    return;
+                }
+
+                std::unique_lock<std::mutex> lock(supervisorMutex);
+                if (supervisorWake.wait_for(lock, backoff, [&] { return supervisorGeneration != generation; })) {
+                    return;
+                }
+                backoff = std::min<std::chrono::milliseconds>(backoff * 2, RECONNECT_BACKOFF_MAX);
+            }
+        }
+
+        bool isCurrentSupervisor(uint64_t generation) {
+            std::lock_guard<std::mutex> lock(supervisorMutex);
+            return supervisorGeneration == generation;
+        }
+
+        // Same handshake as connect(), then replay the session state the
+        // firmware lost with the link. Caller holds mutex
+        bool reopen() {
+            std::string port = deviceInfo.port;
+            if (!openHighSpeed(port)) {
+                // A re-enumerated device may come back under another name
+                if (!portDiscovered) {
+                    return false;
+                }
+                SerialPort::invalidatePortCache();
+                port = Device::findFirstDevice();
+                if (port.empty() || port == deviceInfo.port || !openHighSpeed(port)) {
+                    return false;
+                }
+                deviceInfo.port = port;
+            }
+
+            if (!initializeDevice()) {
+                return false;
+            }
+            negotiateWireProtocol();
+            return restoreSessionState();
+        }
+
+        // initializeDevice() turned button reports on; locks are replayed from
+        // the cache (only bits set by this session are known)
+        bool restoreSessionState() {
+            bool ok = true;
+            if (!monitoring.load()) {
+                ok = serialPort->sendCommand("km.buttons(0)") && ok;
+            }
+            if (lockStateCacheValid.load()) {
+                uint16_t locks = lockStateCache.load();
+                for (size_t bit = 0; bit < LOCK_TARGET_COUNT; ++bit) {
+                    if (locks & (1u << bit)) {
+                        ok = serialPort->sendCommand(LOCK_COMMANDS[bit]) && ok;
+                    }
+                }
+            }
+            return ok;
+        }
+
         void notifyConnectionChange(bool isConnected) {
-            if (connectionCallback) {
+            if (auto callback = connectionCallback.get()) {
                 try {
-                    connectionCallback(isConnected);
+                    (*callback)(isConnected);
                 }
                 catch (...) {
                     // Ignore callback exceptions
@@ -198,7 +567,7 @@ namespace makcu {
         }
 
         // High-performance command execution
-        bool executeCommand(const std::string& command) {
+        bool executeCommand(std::string_view command) {
             if (!connected.load()) {
                 return false;
             }
@@ -223,64 +592,118 @@ namespace makcu {
             return result;
         }
 
-        // Optimized move command with buffer reuse
+        // Relative deltas stay typed down to SerialPort so a backed-up
+        // writer queue can merge them
         bool executeMoveCommand(int32_t x, int32_t y) {
-            std::lock_guard<std::mutex> lock(moveBufferMutex);
-            moveCommandBuffer.clear();
-            moveCommandBuffer.reserve(32); // Pre-allocate reasonable size
-
-            moveCommandBuffer = "km.move(";
-            moveCommandBuffer += std::to_string(x);
-            moveCommandBuffer += ",";
-            moveCommandBuffer += std::to_string(y);
-            moveCommandBuffer += ")";
-
-            return executeCommand(moveCommandBuffer);
-        }
-
-        // Cache-based lock state management
-        void updateLockStateCache(const std::string& target, bool locked) {
-            static const std::unordered_map<std::string, int> lockBitMap = {
-                {"X", 0}, {"Y", 1}, {"LEFT", 2}, {"RIGHT", 3},
-                {"MIDDLE", 4}, {"SIDE1", 5}, {"SIDE2", 6}
-            };
-
-            auto it = lockBitMap.find(target);
-            if (it != lockBitMap.end()) {
-                uint16_t cache = lockStateCache.load();
-                if (locked) {
-                    cache |= (1 << it->second);
-                }
-                else {
-                    cache &= ~(1 << it->second);
-                }
-                lockStateCache.store(cache);
-                lockStateCacheValid.store(true);
+            return executeTimed("km.move", [&] { return serialPort->sendMove(x, y); });
+        }
+
+        // Firmware-interpolated moves; formatted on the stack by SerialPort
+        bool executeSmoothMoveCommand(int32_t x, int32_t y, uint32_t segments) {
+            return executeTimed("km.move", [&] { return serialPort->sendSmoothMove(x, y, segments); });
+        }
+
+        bool executeBezierMoveCommand(int32_t x, int32_t y, uint32_t segments, int32_t cx, int32_t cy) {
+            return executeTimed("km.move", [&] {
+                return serialPort->sendBezierMove(x, y, segments, cx, cy);
+                });
+        }
+
+        template <typename Send>
+        bool executeTimed(std::string_view name, Send&& send) {
+            if (!connected.load()) {
+                return false;
             }
+
+            auto start = std::chrono::high_resolution_clock::now();
+            bool result = send();
+            auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - start);
+            makcu::PerformanceProfiler::logCommandTiming(name, duration);
+            return result;
         }
 
-        bool getLockStateFromCache(const std::string& target) const {
-            static const std::unordered_map<std::string, int> lockBitMap = {
-                {"X", 0}, {"Y", 1}, {"LEFT", 2}, {"RIGHT", 3},
-                {"MIDDLE", 4}, {"SIDE1", 5}, {"SIDE2", 6}
-            };
+        // Buttons go through the connection's encoder (ASCII or binary frame);
+        // profiled under their ASCII name
+        bool executeButtonCommand(MouseButton button, bool pressed, std::string_view name) {
+            if (!connected.load()) {
+                return false;
+            }
 
-            if (!lockStateCacheValid.load()) {
-                return false; // Cache invalid
+            auto start = std::chrono::high_resolution_clock::now();
+            bool result = serialPort->sendButton(button, pressed);
+            auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - start);
+            makcu::PerformanceProfiler::logCommandTiming(name, duration);
+            return result;
+        }
+
+        // Ask the firmware for binary framing; anything but an explicit "1"
+        // (error reply, echo, timeout) keeps ASCII
+        bool negotiateWireProtocol() {
+            serialPort->setWireProtocol(WireProtocol::ASCII);
+            if (!binaryRequested.load()) {
+                return false;
             }
 
-            auto it = lockBitMap.find(target);
-            if (it != lockBitMap.end()) {
-                return (lockStateCache.load() & (1 << it->second)) != 0;
+            std::string response;
+            if (serialPort->query("km.binary(1)", response, std::chrono::milliseconds(50)) && response == "1") {
+                serialPort->setWireProtocol(WireProtocol::BINARY);
+                return true;
             }
             return false;
         }
+
+        bool executeWheelCommand(int32_t delta) {
+            return executeTimed("km.wheel", [&] { return serialPort->sendWheel(delta); });
+        }
+
+        // km.catch_*() reply: a decimal count, parsed without exceptions
+        uint8_t catchButton(const char* command) {
+            std::string response;
+            if (!connected.load() ||
+                !serialPort->query(command, response, std::chrono::milliseconds(50))) {
+                return 0;
+            }
+
+            const char* first = response.data();
+            const char* last = first + response.size();
+            while (first != last && std::isspace(static_cast<unsigned char>(*first))) {
+                ++first;
+            }
+            int value = 0;
+            if (std::from_chars(first, last, value).ec != std::errc()) {
+                return 0;
+            }
+            return static_cast<uint8_t>(value);
+        }
+
+        // Cache-based lock state management (bit = LockTarget)
+        void updateLockStateCache(LockTarget target, bool locked) {
+            uint16_t bit = static_cast<uint16_t>(1u << static_cast<uint8_t>(target));
+            if (locked) {
+                lockStateCache.fetch_or(bit);
+            }
+            else {
+                lockStateCache.fetch_and(static_cast<uint16_t>(~bit));
+            }
+            lockStateCacheValid.store(true);
+        }
+
+        LockStates getLockStatesFromCache() const {
+            LockStates states;
+            if (lockStateCacheValid.load()) {
+                states.mask = static_cast<uint8_t>(lockStateCache.load());
+            }
+            return states;
+        }
     };
 
     // Device implementation
     Device::Device() : m_impl(std::make_unique<Impl>()) {}
 
     Device::~Device() {
+        m_impl->executor.shutdown();  // Queued async calls still reference this
         disconnect();
     }
 
@@ -292,8 +715,8 @@ namespace makcu {
             DeviceInfo info;
             info.port = port;
             info.description = TARGET_DESC;
-            info.vid = MAKCU_VID;
-            info.pid = MAKCU_PID;
+            info.vid = MAKCU_USB_VID;
+            info.pid = MAKCU_USB_PID;
             info.isConnected = false;
             devices.push_back(info);
         }
@@ -321,15 +744,11 @@ namespace makcu {
 
         m_impl->status = ConnectionStatus::CONNECTING;
 
-        // Open at initial baud rate
-        if (!m_impl->serialPort->open(targetPort, INITIAL_BAUD_RATE)) {
-            m_impl->status = ConnectionStatus::CONNECTION_ERROR;
-            return false;
-        }
-
-        // Switch to high-speed mode
-        if (!m_impl->switchToHighSpeedMode()) {
-            m_impl->serialPort->close();
+        // Open at 4 Mbaud, switching from 115200 if the device is not there yet
+        if (!m_impl->openHighSpeed(targetPort)) {
+            if (port.empty()) {
+                SerialPort::invalidatePortCache();  // Discovered port has gone away
+            }
             m_impl->status = ConnectionStatus::CONNECTION_ERROR;
             return false;
         }
@@ -341,30 +760,42 @@ namespace makcu {
             return false;
         }
 
+        // Binary framing if requested and acknowledged, ASCII otherwise
+        m_impl->negotiateWireProtocol();
+
         // Update device info
         m_impl->deviceInfo.port = targetPort;
         m_impl->deviceInfo.description = TARGET_DESC;
-        m_impl->deviceInfo.vid = MAKCU_VID;
-        m_impl->deviceInfo.pid = MAKCU_PID;
+        m_impl->deviceInfo.vid = MAKCU_USB_VID;
+        m_impl->deviceInfo.pid = MAKCU_USB_PID;
         m_impl->deviceInfo.isConnected = true;
+        m_impl->portDiscovered = port.empty();
 
+        m_impl->monitoring.store(true);
         m_impl->connected.store(true);
         m_impl->status = ConnectionStatus::CONNECTED;
+        m_impl->startSupervisor();
         m_impl->notifyConnectionChange(true);
 
         return true;
     }
 
     std::future<bool> Device::connectAsync(const std::string& port) {
-        return std::async(std::launch::async, [this, port]() {
+        return m_impl->executor.submit([this, port]() {
             return connect(port);
             });
     }
 
     void Device::disconnect() {
+        m_impl->stopSupervisor();
         std::lock_guard<std::mutex> lock(m_impl->mutex);
 
         if (!m_impl->connected.load()) {
+            // Abandoned reconnect: the port is already closed
+            if (m_impl->status == ConnectionStatus::CONNECTING) {
+                m_impl->status = ConnectionStatus::DISCONNECTED;
+                m_impl->lockStateCacheValid.store(false);
+            }
             return;
         }
 
@@ -378,7 +809,7 @@ namespace makcu {
     }
 
     std::future<void> Device::disconnectAsync() {
-        return std::async(std::launch::async, [this]() {
+        return m_impl->executor.submit([this]() {
             disconnect();
             });
     }
@@ -400,18 +831,15 @@ namespace makcu {
             return "";
         }
 
-        auto future = m_impl->serialPort->sendTrackedCommand("km.version()", true,
-            std::chrono::milliseconds(100));
-        try {
-            return future.get();
-        }
-        catch (...) {
+        std::string response;
+        if (!m_impl->serialPort->query("km.version()", response, std::chrono::milliseconds(100))) {
             return "";
         }
+        return response;
     }
 
     std::future<std::string> Device::getVersionAsync() const {
-        return std::async(std::launch::async, [this]() {
+        return m_impl->executor.submit([this]() {
             return getVersion();
             });
     }
@@ -422,11 +850,8 @@ namespace makcu {
             return false;
         }
 
-        auto it = m_impl->commandCache.press_commands.find(button);
-        if (it != m_impl->commandCache.press_commands.end()) {
-            return m_impl->executeCommand(it->second);
-        }
-        return false;
+        std::string_view name = buttonCommand(button, true);
+        return !name.empty() && m_impl->executeButtonCommand(button, true, name);
     }
 
     bool Device::mouseUp(MouseButton button) {
@@ -434,11 +859,8 @@ namespace makcu {
             return false;
         }
 
-        auto it = m_impl->commandCache.release_commands.find(button);
-        if (it != m_impl->commandCache.release_commands.end()) {
-            return m_impl->executeCommand(it->second);
-        }
-        return false;
+        std::string_view name = buttonCommand(button, false);
+        return !name.empty() && m_impl->executeButtonCommand(button, false, name);
     }
 
     bool Device::click(MouseButton button) {
@@ -447,35 +869,27 @@ namespace makcu {
         }
 
         // For maximum performance, batch press+release
-        auto pressIt = m_impl->commandCache.press_commands.find(button);
-        auto releaseIt = m_impl->commandCache.release_commands.find(button);
-
-        if (pressIt != m_impl->commandCache.press_commands.end() &&
-            releaseIt != m_impl->commandCache.release_commands.end()) {
-
-            bool result1 = m_impl->executeCommand(pressIt->second);
-            bool result2 = m_impl->executeCommand(releaseIt->second);
-            return result1 && result2;
+        std::string_view press = buttonCommand(button, true);
+        std::string_view release = buttonCommand(button, false);
+        if (press.empty()) {
+            return false;
         }
-        return false;
+
+        bool result1 = m_impl->executeButtonCommand(button, true, press);
+        bool result2 = m_impl->executeButtonCommand(button, false, release);
+        return result1 && result2;
     }
 
     std::future<bool> Device::mouseDownAsync(MouseButton button) {
-        return std::async(std::launch::async, [this, button]() {
-            return mouseDown(button);
-            });
+        return readyFuture(mouseDown(button));
     }
 
     std::future<bool> Device::mouseUpAsync(MouseButton button) {
-        return std::async(std::launch::async, [this, button]() {
-            return mouseUp(button);
-            });
+        return readyFuture(mouseUp(button));
     }
 
     std::future<bool> Device::clickAsync(MouseButton button) {
-        return std::async(std::launch::async, [this, button]() {
-            return click(button);
-            });
+        return readyFuture(click(button));
     }
 
     bool Device::mouseButtonState(MouseButton button) {
@@ -489,9 +903,7 @@ namespace makcu {
     }
 
     std::future<bool> Device::mouseButtonStateAsync(MouseButton button) {
-        return std::async(std::launch::async, [this, button]() {
-            return mouseButtonState(button);
-            });
+        return readyFuture(mouseButtonState(button));
     }
 
     // High-performance movement methods
@@ -508,9 +920,7 @@ namespace makcu {
             return false;
         }
 
-        std::string command = "km.move(" + std::to_string(x) + "," +
-            std::to_string(y) + "," + std::to_string(segments) + ")";
-        return m_impl->executeCommand(command);
+        return m_impl->executeSmoothMoveCommand(x, y, segments);
     }
 
     bool Device::mouseMoveBezier(int32_t x, int32_t y, uint32_t segments,
@@ -519,29 +929,20 @@ namespace makcu {
             return false;
         }
 
-        std::string command = "km.move(" + std::to_string(x) + "," + std::to_string(y) + "," +
-            std::to_string(segments) + "," + std::to_string(ctrl_x) + "," +
-            std::to_string(ctrl_y) + ")";
-        return m_impl->executeCommand(command);
+        return m_impl->executeBezierMoveCommand(x, y, segments, ctrl_x, ctrl_y);
     }
 
     std::future<bool> Device::mouseMoveAsync(int32_t x, int32_t y) {
-        return std::async(std::launch::async, [this, x, y]() {
-            return mouseMove(x, y);
-            });
+        return readyFuture(mouseMove(x, y));
     }
 
     std::future<bool> Device::mouseMoveSmoothAsync(int32_t x, int32_t y, uint32_t segments) {
-        return std::async(std::launch::async, [this, x, y, segments]() {
-            return mouseMoveSmooth(x, y, segments);
-            });
+        return readyFuture(mouseMoveSmooth(x, y, segments));
     }
 
     std::future<bool> Device::mouseMoveBezierAsync(int32_t x, int32_t y, uint32_t segments,
         int32_t ctrl_x, int32_t ctrl_y) {
-        return std::async(std::launch::async, [this, x, y, segments, ctrl_x, ctrl_y]() {
-            return mouseMoveBezier(x, y, segments, ctrl_x, ctrl_y);
-            });
+        return readyFuture(mouseMoveBezier(x, y, segments, ctrl_x, ctrl_y));
     }
 
     bool Device::mouseWheel(int32_t delta) {
@@ -549,225 +950,109 @@ namespace makcu {
             return false;
         }
 
-        std::string command = "km.wheel(" + std::to_string(delta) + ")";
-        return m_impl->executeCommand(command);
+        return m_impl->executeWheelCommand(delta);
     }
 
     std::future<bool> Device::mouseWheelAsync(int32_t delta) {
-        return std::async(std::launch::async, [this, delta]() {
-            return mouseWheel(delta);
-            });
+        return readyFuture(mouseWheel(delta));
     }
 
     // Mouse locking methods with caching
-    bool Device::lockMouseX(bool lock) {
-        if (!m_impl->connected.load()) return false;
-
-        const std::string& command = lock ?
-            m_impl->commandCache.lock_commands.at("X") :
-            m_impl->commandCache.unlock_commands.at("X");
+    bool Device::lockMouse(LockTarget target, bool lock) {
+        size_t index = static_cast<size_t>(target);
+        if (!m_impl->connected.load() || index >= LOCK_TARGET_COUNT) return false;
 
-        bool result = m_impl->executeCommand(command);
+        bool result = m_impl->executeCommand(lock ? LOCK_COMMANDS[index] : UNLOCK_COMMANDS[index]);
         if (result) {
-            m_impl->updateLockStateCache("X", lock);
+            m_impl->updateLockStateCache(target, lock);
         }
         return result;
     }
 
-    bool Device::lockMouseY(bool lock) {
-        if (!m_impl->connected.load()) return false;
-
-        const std::string& command = lock ?
-            m_impl->commandCache.lock_commands.at("Y") :
-            m_impl->commandCache.unlock_commands.at("Y");
+    bool Device::lockMouseX(bool lock) {
+        return lockMouse(LockTarget::X, lock);
+    }
 
-        bool result = m_impl->executeCommand(command);
-        if (result) {
-            m_impl->updateLockStateCache("Y", lock);
-        }
-        return result;
+    bool Device::lockMouseY(bool lock) {
+        return lockMouse(LockTarget::Y, lock);
     }
 
     bool Device::lockMouseLeft(bool lock) {
-        if (!m_impl->connected.load()) return false;
-
-        const std::string& command = lock ?
-            m_impl->commandCache.lock_commands.at("LEFT") :
-            m_impl->commandCache.unlock_commands.at("LEFT");
-
-        bool result = m_impl->executeCommand(command);
-        if (result) {
-            m_impl->updateLockStateCache("LEFT", lock);
-        }
-        return result;
+        return lockMouse(LockTarget::LEFT, lock);
     }
 
     bool Device::lockMouseMiddle(bool lock) {
-        if (!m_impl->connected.load()) return false;
-
-        const std::string& command = lock ?
-            m_impl->commandCache.lock_commands.at("MIDDLE") :
-            m_impl->commandCache.unlock_commands.at("MIDDLE");
-
-        bool result = m_impl->executeCommand(command);
-        if (result) {
-            m_impl->updateLockStateCache("MIDDLE", lock);
-        }
-        return result;
+        return lockMouse(LockTarget::MIDDLE, lock);
     }
 
     bool Device::lockMouseRight(bool lock) {
-        if (!m_impl->connected.load()) return false;
-
-        const std::string& command = lock ?
-            m_impl->commandCache.lock_commands.at("RIGHT") :
-            m_impl->commandCache.unlock_commands.at("RIGHT");
-
-        bool result = m_impl->executeCommand(command);
-        if (result) {
-            m_impl->updateLockStateCache("RIGHT", lock);
-        }
-        return result;
+        return lockMouse(LockTarget::RIGHT, lock);
     }
 
     bool Device::lockMouseSide1(bool lock) {
-        if (!m_impl->connected.load()) return false;
-
-        const std::string& command = lock ?
-            m_impl->commandCache.lock_commands.at("SIDE1") :
-            m_impl->commandCache.unlock_commands.at("SIDE1");
-
-        bool result = m_impl->executeCommand(command);
-        if (result) {
-            m_impl->updateLockStateCache("SIDE1", lock);
-        }
-        return result;
+        return lockMouse(LockTarget::SIDE1, lock);
     }
 
     bool Device::lockMouseSide2(bool lock) {
-        if (!m_impl->connected.load()) return false;
-
-        const std::string& command = lock ?
-            m_impl->commandCache.lock_commands.at("SIDE2") :
-            m_impl->commandCache.unlock_commands.at("SIDE2");
-
-        bool result = m_impl->executeCommand(command);
-        if (result) {
-            m_impl->updateLockStateCache("SIDE2", lock);
-        }
-        return result;
+        return lockMouse(LockTarget::SIDE2, lock);
     }
 
     // Fast cached lock state queries
+    bool Device::isLocked(LockTarget target) const {
+        return m_impl->getLockStatesFromCache().isLocked(target);
+    }
+
     bool Device::isMouseXLocked() const {
-        return m_impl->getLockStateFromCache("X");
+        return isLocked(LockTarget::X);
     }
 
     bool Device::isMouseYLocked() const {
-        return m_impl->getLockStateFromCache("Y");
+        return isLocked(LockTarget::Y);
     }
 
     bool Device::isMouseLeftLocked() const {
-        return m_impl->getLockStateFromCache("LEFT");
+        return isLocked(LockTarget::LEFT);
     }
 
     bool Device::isMouseMiddleLocked() const {
-        return m_impl->getLockStateFromCache("MIDDLE");
+        return isLocked(LockTarget::MIDDLE);
     }
 
     bool Device::isMouseRightLocked() const {
-        return m_impl->getLockStateFromCache("RIGHT");
+        return isLocked(LockTarget::RIGHT);
     }
 
     bool Device::isMouseSide1Locked() const {
-        return m_impl->getLockStateFromCache("SIDE1");
+        return isLocked(LockTarget::SIDE1);
     }
 
     bool Device::isMouseSide2Locked() const {
-        return m_impl->getLockStateFromCache("SIDE2");
-    }
-
-    std::unordered_map<std::string, bool> Device::getAllLockStates() const {
-        return {
-            {"X", isMouseXLocked()},
-            {"Y", isMouseYLocked()},
-            {"LEFT", isMouseLeftLocked()},
-            {"RIGHT", isMouseRightLocked()},
-            {"MIDDLE", isMouseMiddleLocked()},
-            {"SIDE1", isMouseSide1Locked()},
-            {"SIDE2", isMouseSide2Locked()}
-        };
+        return isLocked(LockTarget::SIDE2);
+    }
+
+    LockStates Device::getAllLockStates() const {
+        return m_impl->getLockStatesFromCache();
     }
 
     // Mouse input catching methods
     uint8_t Device::catchMouseLeft() {
-        if (!m_impl->connected.load()) return 0;
-
-        auto future = m_impl->serialPort->sendTrackedCommand("km.catch_ml()", true,
-            std::chrono::milliseconds(50));
-        try {
-            std::string response = future.get();
-            return static_cast<uint8_t>(std::stoi(response));
-        }
-        catch (...) {
-            return 0;
-        }
+        return m_impl->catchButton("km.catch_ml()");
     }
 
     uint8_t Device::catchMouseMiddle() {
-        if (!m_impl->connected.load()) return 0;
-
-        auto future = m_impl->serialPort->sendTrackedCommand("km.catch_mm()", true,
-            std::chrono::milliseconds(50));
-        try {
-            std::string response = future.get();
-            return static_cast<uint8_t>(std::stoi(response));
-        }
-        catch (...) {
-            return 0;
-        }
+        return m_impl->catchButton("km.catch_mm()");
     }
 
     uint8_t Device::catchMouseRight() {
-        if (!m_impl->connected.load()) return 0;
-
-        auto future = m_impl->serialPort->sendTrackedCommand("km.catch_mr()", true,
-            std::chrono::milliseconds(50));
-        try {
-            std::string response = future.get();
-            return static_cast<uint8_t>(std::stoi(response));
-        }
-        catch (...) {
-            return 0;
-        }
+        return m_impl->catchButton("km.catch_mr()");
     }
 
     uint8_t Device::catchMouseSide1() {
-        if (!m_impl->connected.load()) return 0;
-
-        auto future = m_impl->serialPort->sendTrackedCommand("km.catch_ms1()", true,
-            std::chrono::milliseconds(50));
-        try {
-            std::string response = future.get();
-            return static_cast<uint8_t>(std::stoi(response));
-        }
-        catch (...) {
-            return 0;
-        }
+        return m_impl->catchButton("km.catch_ms1()");
     }
 
     uint8_t Device::catchMouseSide2() {
-        if (!m_impl->connected.load()) return 0;
-
-        auto future = m_impl->serialPort->sendTrackedCommand("km.catch_ms2()", true,
-            std::chrono::milliseconds(50));
-        try {
-            std::string response = future.get();
-            return static_cast<uint8_t>(std::stoi(response));
-        }
-        catch (...) {
-            return 0;
-        }
+        return m_impl->catchButton("km.catch_ms2()");
     }
 
     // Button monitoring methods
@@ -777,7 +1062,11 @@ namespace makcu {
         }
 
         std::string command = enable ? "km.buttons(1)" : "km.buttons(0)";
-        return m_impl->executeCommand(command);
+        if (!m_impl->executeCommand(command)) {
+            return false;
+        }
+        m_impl->monitoring.store(enable);  // Replayed after a reconnect
+        return true;
     }
 
     bool Device::isButtonMonitoringEnabled() const {
@@ -792,14 +1081,11 @@ namespace makcu {
     std::string Device::getMouseSerial() {
         if (!m_impl->connected.load()) return "";
 
-        auto future = m_impl->serialPort->sendTrackedCommand("km.serial()", true,
-            std::chrono::milliseconds(100));
-        try {
-            return future.get();
-        }
-        catch (...) {
+        std::string response;
+        if (!m_impl->serialPort->query("km.serial()", response, std::chrono::milliseconds(100))) {
             return "";
         }
+        return response;
     }
 
     bool Device::setMouseSerial(const std::string& serial) {
@@ -815,18 +1101,17 @@ namespace makcu {
     }
 
     std::future<std::string> Device::getMouseSerialAsync() {
-        return std::async(std::launch::async, [this]() {
+        return m_impl->executor.submit([this]() {
             return getMouseSerial();
             });
     }
 
     std::future<bool> Device::setMouseSerialAsync(const std::string& serial) {
-        return std::async(std::launch::async, [this, serial]() {
-            return setMouseSerial(serial);
-            });
+        return readyFuture(setMouseSerial(serial));
     }
 
     bool Device::setBaudRate(uint32_t baudRate) {
+        std::lock_guard<std::mutex> lock(m_impl->mutex);
         if (!m_impl->connected.load()) {
             return false;
         }
@@ -835,31 +1120,123 @@ namespace makcu {
     }
 
     void Device::setMouseButtonCallback(MouseButtonCallback callback) {
-        m_impl->mouseButtonCallback = callback;
+        m_impl->mouseButtonCallback.set(std::move(callback));
     }
 
     void Device::setConnectionCallback(ConnectionCallback callback) {
-        m_impl->connectionCallback = callback;
+        m_impl->connectionCallback.set(std::move(callback));
+    }
+
+    void Device::setReconnectCallback(ReconnectCallback callback) {
+        m_impl->reconnectCallback.set(std::move(callback));
+    }
+
+    void Device::enableAutoReconnect(bool enable) {
+        m_impl->autoReconnect.store(enable);
+    }
+
+    bool Device::isAutoReconnectEnabled() const {
+        return m_impl->autoReconnect.load();
     }
 
     // High-level automation methods
+    // Clicks are scheduled at t0 + i * delay on the timer thread, so the
+    // sequence does not drift by the oversleep of each step
     bool Device::clickSequence(const std::vector<MouseButton>& buttons,
         std::chrono::milliseconds delay) {
         if (!m_impl->connected.load()) {
             return false;
         }
+        if (buttons.empty()) {
+            return true;
+        }
+        return clickSequenceAsync(buttons, delay).wait();
+    }
 
+    ScheduledAction Device::scheduleMouseDown(MouseButton button, TimePoint at) {
+        std::string_view command = buttonCommand(button, true);
+        if (!m_impl->connected.load() || command.empty()) {
+            return ScheduledAction();
+        }
+        return m_impl->serialPort->schedule({ { at, std::string(command) } });
+    }
+
+    ScheduledAction Device::scheduleMouseUp(MouseButton button, TimePoint at) {
+        std::string_view command = buttonCommand(button, false);
+        if (!m_impl->connected.load() || command.empty()) {
+            return ScheduledAction();
+        }
+        return m_impl->serialPort->schedule({ { at, std::string(command) } });
+    }
+
+    ScheduledAction Device::scheduleClick(MouseButton button, TimePoint at,
+        std::chrono::milliseconds holdFor) {
+        std::string_view press = buttonCommand(button, true);
+        std::string_view release = buttonCommand(button, false);
+        if (!m_impl->connected.load() || press.empty()) {
+            return ScheduledAction();
+        }
+        return m_impl->serialPort->schedule({ { at, std::string(press) }, { at + holdFor, std::string(release) } });
+    }
+
+    ScheduledAction Device::clickSequenceAsync(const std::vector<MouseButton>& buttons,
+        std::chrono::milliseconds delay) {
+        if (!m_impl->connected.load()) {
+            return ScheduledAction();
+        }
+
+        std::vector<SerialPort::ScheduleStep> steps;
+        steps.reserve(buttons.size() * 2);
+        auto at = std::chrono::steady_clock::now();
         for (const auto& button : buttons) {
-            if (!click(button)) {
-                return false;
-            }
-            if (delay.count() > 0) {
-                std::this_thread::sleep_for(delay);
+            std::string_view press = buttonCommand(button, true);
+            std::string_view release = buttonCommand(button, false);
+            if (press.empty()) {
+                return ScheduledAction();
             }
+            steps.emplace_back(at, press);
+            steps.emplace_back(at, release);
+            at += delay;
+        }
+        return m_impl->serialPort->schedule(steps);
+    }
+
+    ScheduleStats Device::getScheduleStats() const {
+        return m_impl->serialPort->getScheduleStats();
+    }
+
+    bool ScheduledAction::cancel() {
+        if (!m_state || m_state->remaining.load() == 0) {
+            return false;
+        }
+        // Rechecked under the lock: the hook is dropped once the last step fired
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        if (m_state->remaining.load() == 0 || m_state->cancelled.exchange(true)) {
+            return false;
         }
+        if (m_state->held != 0 && m_state->releaseHeld) {
+            m_state->releaseHeld(m_state->held);
+        }
+        m_state->held = 0;
+        m_state->done.notify_all();
         return true;
     }
 
+    bool ScheduledAction::isPending() const {
+        return m_state && !m_state->cancelled.load() && m_state->remaining.load() > 0;
+    }
+
+    bool ScheduledAction::wait() {
+        if (!m_state) {
+            return false;
+        }
+        std::unique_lock<std::mutex> lock(m_state->mutex);
+        m_state->done.wait(lock, [this] {
+            return m_state->remaining.load() == 0 || m_state->cancelled.load();
+            });
+        return m_state->remaining.load() == 0 && m_state->failed.load() == 0;
+    }
+
     bool Device::movePattern(const std::vector<std::pair<int32_t, int32_t>>& points,
         bool smooth, uint32_t segments) {
         if (!m_impl->connected.load()) {
@@ -881,6 +1258,165 @@ namespace makcu {
         return true;
     }
 
+    struct PreparedSequence::Data {
+        WireProtocol protocol = WireProtocol::ASCII;
+        std::vector<SequenceStep> steps;                   // Kept for transformed replays
+        std::shared_ptr<const std::vector<char>> bytes;
+        std::vector<SerialPort::EncodedSlot> slots;        // Timing table
+    };
+
+    size_t PreparedSequence::size() const {
+        return m_data ? m_data->steps.size() : 0;
+    }
+
+    std::chrono::microseconds PreparedSequence::duration() const {
+        if (!m_data || m_data->slots.empty()) {
+            return std::chrono::microseconds(0);
+        }
+        return std::chrono::duration_cast<std::chrono::microseconds>(m_data->slots.back().offset);
+    }
+
+    WireProtocol PreparedSequence::protocol() const {
+        return m_data ? m_data->protocol : WireProtocol::ASCII;
+    }
+
+    // delta * scale + offset, rounded; the rounding error is carried into
+    // the next move on the same axis
+    static int32_t transformDelta(int32_t delta, double scale, int32_t offset, double& carry) {
+        double exact = delta * scale + offset + carry;
+        double rounded = std::round(exact);
+        carry = exact - rounded;
+        return static_cast<int32_t>(std::clamp(rounded,
+            static_cast<double>(std::numeric_limits<int32_t>::min()),
+            static_cast<double>(std::numeric_limits<int32_t>::max())));
+    }
+
+    // Encode steps back to back; steps due at the same offset share a slot
+    // (one write, in the most urgent class among them). False on an unknown button
+    static bool encodeSequence(const std::vector<SequenceStep>& steps, const CommandEncoder& encoder,
+        const ReplayTransform& transform, std::vector<char>& bytes, std::vector<SerialPort::EncodedSlot>& slots) {
+        bool identity = transform.isIdentity();
+        double carryX = 0.0;
+        double carryY = 0.0;
+        std::chrono::nanoseconds offset(0);
+
+        for (const SequenceStep& step : steps) {
+            size_t begin = bytes.size();
+            CommandPriority priority = CommandPriority::MOTION;
+            offset += step.delay;
+
+            switch (step.kind) {
+            case SequenceStep::Kind::MOVE: {
+                int32_t x = identity ? step.x : transformDelta(step.x, transform.scaleX, transform.offsetX, carryX);
+                int32_t y = identity ? step.y : transformDelta(step.y, transform.scaleY, transform.offsetY, carryY);
+                if (step.segments > 0) {
+                    char line[CommandEncoder::MAX_TEXT_COMMAND];
+                    bytes.insert(bytes.end(), line, line + CommandEncoder::formatMove(line, x, y, step.segments));
+                }
+                else {
+                    encoder.appendMove(bytes, x, y);
+                }
+                break;
+            }
+            case SequenceStep::Kind::WHEEL:
+                encoder.appendWheel(bytes, step.x);
+                break;
+            case SequenceStep::Kind::PRESS:
+            case SequenceStep::Kind::RELEASE:
+                if (!encoder.appendButton(bytes, step.button, step.kind == SequenceStep::Kind::PRESS)) {
+                    return false;
+                }
+                priority = CommandPriority::CONTROL;
+                break;
+            }
+
+            uint32_t length = static_cast<uint32_t>(bytes.size() - begin);
+            if (slots.empty() || slots.back().offset != offset) {
+                slots.push_back({ offset, static_cast<uint32_t>(begin), 0, priority });
+            }
+            SerialPort::EncodedSlot& slot = slots.back();
+            slot.length += length;
+            slot.priority = std::min(slot.priority, priority);
+
+            // Net button state the slot leaves behind, for cancel()
+            uint8_t bit = static_cast<uint8_t>(1u << static_cast<unsigned>(step.button));
+            if (step.kind == SequenceStep::Kind::PRESS) {
+                slot.presses = static_cast<uint8_t>(slot.presses | bit);
+                slot.releases = static_cast<uint8_t>(slot.releases & ~bit);
+            }
+            else if (step.kind == SequenceStep::Kind::RELEASE) {
+                slot.releases = static_cast<uint8_t>(slot.releases | bit);
+                slot.presses = static_cast<uint8_t>(slot.presses & ~bit);
+            }
+        }
+        return true;
+    }
+
+    PreparedSequence Device::prepare(const std::vector<SequenceStep>& steps) const {
+        auto data = std::make_shared<PreparedSequence::Data>();
+        data->protocol = m_impl->serialPort->getWireProtocol();
+        data->steps = steps;
+
+        auto bytes = std::make_shared<std::vector<char>>();
+        if (!encodeSequence(steps, CommandEncoder::forProtocol(data->protocol), ReplayTransform(),
+            *bytes, data->slots)) {
+            return PreparedSequence();
+        }
+        data->bytes = std::move(bytes);
+        return PreparedSequence(std::move(data));
+    }
+
+    bool Device::replay(const PreparedSequence& sequence, const ReplayTransform& transform) {
+        return replayAsync(sequence, transform).wait();
+    }
+
+    // The slot due at the start is written on the caller's thread; only
+    // delayed slots go through the scheduler, which learns what that first
+    // slot left pressed. If that first write fails the rest is not scheduled
+    static ScheduledAction submitSlots(SerialPort& port, std::chrono::steady_clock::time_point start,
+        std::shared_ptr<const std::vector<char>> bytes, const std::vector<SerialPort::EncodedSlot>& slots) {
+        const SerialPort::EncodedSlot* first = slots.data();
+        size_t count = slots.size();
+        uint8_t held = 0;
+        if (first->offset.count() == 0) {
+            held = first->presses;
+            if (!port.sendEncoded(bytes->data() + first->begin, first->length, first->priority) || count == 1) {
+                auto state = std::make_shared<ScheduledAction::State>();
+                state->failed = count == 1 ? 0 : 1;
+                return ScheduledAction(std::move(state));
+            }
+            ++first;
+            --count;
+        }
+        return port.scheduleEncoded(start, std::move(bytes), first, count, held);
+    }
+
+    ScheduledAction Device::replayAsync(const PreparedSequence& sequence, const ReplayTransform& transform) {
+        const PreparedSequence::Data* data = sequence.m_data.get();
+        if (!m_impl->connected.load() || !data || m_impl->serialPort->getWireProtocol() != data->protocol) {
+            return ScheduledAction();
+        }
+        if (data->slots.empty()) {
+            return ScheduledAction(std::make_shared<ScheduledAction::State>());  // Nothing to send
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        if (transform.isIdentity()) {
+            return submitSlots(*m_impl->serialPort, start, data->bytes, data->slots);
+        }
+
+        std::lock_guard<std::mutex> lock(m_impl->replayMutex);
+        auto& bytes = m_impl->replayBytes;
+        if (!bytes || bytes.use_count() > 1) {
+            bytes = std::make_shared<std::vector<char>>();  // Previous replay still pending
+            bytes->reserve(data->bytes->size());
+        }
+        bytes->clear();
+        m_impl->replaySlots.clear();
+        encodeSequence(data->steps, CommandEncoder::forProtocol(data->protocol), transform, *bytes, m_impl->replaySlots);
+        return submitSlots(*m_impl->serialPort, start, bytes, m_impl->replaySlots);
+    }
+
     void Device::enableHighPerformanceMode(bool enable) {
         m_impl->highPerformanceMode.store(enable);
     }
@@ -889,62 +1425,190 @@ namespace makcu {
         return m_impl->highPerformanceMode.load();
     }
 
+    // Port configuration setters hold the device mutex so they cannot land
+    // between the supervisor's close() and reopen() handshake
+    void Device::enableWriterThread(bool enable) {
+        // SerialPort keeps the setting across the reopen in switchToHighSpeedMode
+        std::lock_guard<std::mutex> lock(m_impl->mutex);
+        m_impl->serialPort->setWriterThreadEnabled(enable);
+    }
+
+    bool Device::isWriterThreadEnabled() const {
+        return m_impl->serialPort->isWriterThreadEnabled();
+    }
+
+    WriterStats Device::getWriterStats() const {
+        return m_impl->serialPort->getWriterStats();
+    }
+
+    void Device::enableMoveCoalescing(bool enable) {
+        m_impl->serialPort->setCoalescingEnabled(enable);
+    }
+
+    bool Device::isMoveCoalescingEnabled() const {
+        return m_impl->serialPort->isCoalescingEnabled();
+    }
+
+    void Device::setMovePacingRate(uint32_t ticksPerSecond) {
+        // The tick is 1 us at the finest: faster rates are clamped to 1 MHz
+        // rather than truncating to a 0 interval, which would mean unpaced
+        auto interval = ticksPerSecond ?
+            std::chrono::microseconds(std::max<uint32_t>(1000000 / ticksPerSecond, 1)) : std::chrono::microseconds(0);
+        std::lock_guard<std::mutex> lock(m_impl->mutex);
+        m_impl->serialPort->setPacingInterval(interval);
+    }
+
+    uint32_t Device::getMovePacingRate() const {
+        auto interval = m_impl->serialPort->getPacingInterval().count();
+        return interval > 0 ? static_cast<uint32_t>(1000000 / interval) : 0;
+    }
+
+    void Device::enablePriorityClasses(bool enable) {
+        std::lock_guard<std::mutex> lock(m_impl->mutex);
+        m_impl->serialPort->setPriorityClassesEnabled(enable);
+    }
+
+    bool Device::isPriorityClassesEnabled() const {
+        return m_impl->serialPort->isPriorityClassesEnabled();
+    }
+
+    void Device::setStarvationLimit(std::chrono::microseconds limit) {
+        m_impl->serialPort->setStarvationLimit(limit);
+    }
+
+    std::chrono::microseconds Device::getStarvationLimit() const {
+        return m_impl->serialPort->getStarvationLimit();
+    }
+
+    bool Device::enableBinaryProtocol(bool enable) {
+        std::lock_guard<std::mutex> lock(m_impl->mutex);
+
+        bool wasBinary = m_impl->serialPort->getWireProtocol() == WireProtocol::BINARY;
+        m_impl->binaryRequested = enable;
+        if (!m_impl->connected.load()) {
+            return false;
+        }
+        if (!enable) {
+            m_impl->serialPort->setWireProtocol(WireProtocol::ASCII);
+            if (wasBinary) {
+                m_impl->serialPort->sendCommand("km.binary(0)");
+            }
+            return false;
+        }
+        return wasBinary || m_impl->negotiateWireProtocol();
+    }
+
+    WireProtocol Device::getWireProtocol() const {
+        return m_impl->serialPort->getWireProtocol();
+    }
+
+    ReceiveStats Device::getReceiveStats() const {
+        return m_impl->serialPort->getReceiveStats();
+    }
+
+    void Device::setReceiveSpinTime(std::chrono::microseconds spin) {
+        m_impl->serialPort->setReceiveSpinTime(spin);
+    }
+
+    std::chrono::microseconds Device::getReceiveSpinTime() const {
+        return m_impl->serialPort->getReceiveSpinTime();
+    }
+
+    bool Device::setIoBackend(IoBackend backend) {
+        std::lock_guard<std::mutex> lock(m_impl->mutex);
+        return m_impl->serialPort->setIoBackend(backend);
+    }
+
+    IoBackend Device::getIoBackend() const {
+        return m_impl->serialPort->getIoBackend();
+    }
+
+    bool Device::setRealtimeMode(const RealtimeConfig& config) {
+        std::lock_guard<std::mutex> lock(m_impl->mutex);
+        return m_impl->serialPort->setRealtimeMode(config);
+    }
+
+    RealtimeStatus Device::getRealtimeStatus() const {
+        return m_impl->serialPort->getRealtimeStatus();
+    }
+
+    void Device::setQuerySpinTime(std::chrono::microseconds spin) {
+        m_impl->serialPort->setQuerySpinTime(spin);
+    }
+
+    std::chrono::microseconds Device::getQuerySpinTime() const {
+        return m_impl->serialPort->getQuerySpinTime();
+    }
+
     // Batch command builder implementation
     Device::BatchCommandBuilder Device::createBatch() {
         return BatchCommandBuilder(this);
     }
 
     Device::BatchCommandBuilder& Device::BatchCommandBuilder::move(int32_t x, int32_t y) {
-        m_commands.push_back("km.move(" + std::to_string(x) + "," + std::to_string(y) + ")");
+        beginCommand(CommandPriority::MOTION);
+        CommandEncoder::forProtocol(m_protocol).appendMove(m_buffer, x, y);
         return *this;
     }
 
     Device::BatchCommandBuilder& Device::BatchCommandBuilder::click(MouseButton button) {
-        auto& cache = m_device->m_impl->commandCache;
-        auto pressIt = cache.press_commands.find(button);
-        auto releaseIt = cache.release_commands.find(button);
-
-        if (pressIt != cache.press_commands.end() && releaseIt != cache.release_commands.end()) {
-            m_commands.push_back(pressIt->second);
-            m_commands.push_back(releaseIt->second);
+        if (!buttonCommand(button, true).empty()) {
+            beginCommand(CommandPriority::CONTROL);
+            const CommandEncoder& encoder = CommandEncoder::forProtocol(m_protocol);
+            encoder.appendButton(m_buffer, button, true);
+            encoder.appendButton(m_buffer, button, false);
+            ++m_count;  // Two commands on the wire
         }
         return *this;
     }
 
     Device::BatchCommandBuilder& Device::BatchCommandBuilder::press(MouseButton button) {
-        auto& cache = m_device->m_impl->commandCache;
-        auto it = cache.press_commands.find(button);
-        if (it != cache.press_commands.end()) {
-            m_commands.push_back(it->second);
+        if (!buttonCommand(button, true).empty()) {
+            beginCommand(CommandPriority::CONTROL);
+            CommandEncoder::forProtocol(m_protocol).appendButton(m_buffer, button, true);
         }
         return *this;
     }
 
     Device::BatchCommandBuilder& Device::BatchCommandBuilder::release(MouseButton button) {
-        auto& cache = m_device->m_impl->commandCache;
-        auto it = cache.release_commands.find(button);
-        if (it != cache.release_commands.end()) {
-            m_commands.push_back(it->second);
+        if (!buttonCommand(button, false).empty()) {
+            beginCommand(CommandPriority::CONTROL);
+            CommandEncoder::forProtocol(m_protocol).appendButton(m_buffer, button, false);
         }
         return *this;
     }
 
     Device::BatchCommandBuilder& Device::BatchCommandBuilder::scroll(int32_t delta) {
-        m_commands.push_back("km.wheel(" + std::to_string(delta) + ")");
+        beginCommand(CommandPriority::MOTION);
+        CommandEncoder::forProtocol(m_protocol).appendWheel(m_buffer, delta);
         return *this;
     }
 
     bool Device::BatchCommandBuilder::execute() {
-        if (!m_device->m_impl->connected.load()) {
+        Impl& impl = *m_device->m_impl;
+        if (!impl.connected.load() || (m_count > 0 && impl.serialPort->getWireProtocol() != m_protocol)) {
             return false;
         }
 
-        for (const auto& command : m_commands) {
-            if (!m_device->m_impl->executeCommand(command)) {
-                return false;
-            }
+        return impl.executeTimed("batch", [&] {
+            return impl.serialPort->sendEncoded(m_buffer.data(), m_buffer.size(), m_priority);
+            });
+    }
+
+    void Device::BatchCommandBuilder::reset() {
+        m_buffer.clear();
+        m_count = 0;
+        m_priority = CommandPriority::QUERY;
+    }
+
+    // The whole batch goes out in one class so its order is kept; it takes
+    // the most urgent class among its commands
+    void Device::BatchCommandBuilder::beginCommand(CommandPriority priority) {
+        if (m_count == 0) {
+            m_protocol = m_device->m_impl->serialPort->getWireProtocol();
         }
-        return true;
+        m_priority = std::min(m_priority, priority);
+        ++m_count;
     }
 
     // Legacy raw command interface (not recommended)
@@ -986,6 +1650,11 @@ namespace makcu {
         return "UNKNOWN";
     }
 
+    std::string_view lockTargetName(LockTarget target) {
+        size_t index = static_cast<size_t>(target);
+        return index < LOCK_TARGET_NAMES.size() ? LOCK_TARGET_NAMES[index] : "UNKNOWN";
+    }
+
     MouseButton stringToMouseButton(const std::string& buttonName) {
         std::string upper = buttonName;
         std::transform(upper.begin(), upper.end(), upper.begin(),
@@ -6,277 +6,2796 @@
 #include <string>
 #include <cstring>
 #include <chrono>
+#include <charconv>
+#include <limits>
+#include <utility>
+
+// MAKCU_NO_SIMD forces the scalar receive scan (benchmark baseline)
+#if defined(MAKCU_NO_SIMD)
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define MAKCU_SIMD_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MAKCU_SIMD_SSE2 1
+#endif
+#if defined(_MSC_VER) && (defined(MAKCU_SIMD_AVX2) || defined(MAKCU_SIMD_SSE2))
+#include <intrin.h>
+#endif
 
 #ifdef _WIN32
 #include <setupapi.h>
 #include <devguid.h>
 #include <cfgmgr32.h>
 #pragma comment(lib, "setupapi.lib")
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <poll.h>
+#include <cerrno>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#include <sched.h>
+#ifdef __linux__
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#define MAKCU_IO_URING 1
+#endif
+#include <linux/serial.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <sys/inotify.h>
+#include <dirent.h>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#endif
+#ifdef __APPLE__
+#include <IOKit/serial/ioss.h>
+#endif
 #endif
 
 namespace makcu {
 
-    SerialPort::SerialPort()
-        : m_baudRate(115200)
-        , m_timeout(100)  // Reduced from 1000ms
-        , m_isOpen(false)
-#ifdef _WIN32
-        , m_handle(INVALID_HANDLE_VALUE)
-#else
-        , m_fd(-1)
+#ifndef _WIN32
+    namespace {
+
+        // Map a numeric baud rate onto a termios speed constant, 0 if none exists
+        speed_t toTermiosSpeed(uint32_t baudRate) {
+            switch (baudRate) {
+            case 9600: return B9600;
+            case 19200: return B19200;
+            case 38400: return B38400;
+            case 57600: return B57600;
+            case 115200: return B115200;
+            case 230400: return B230400;
+#ifdef B460800
+            case 460800: return B460800;
 #endif
-    {
-#ifdef _WIN32
-        memset(&m_dcb, 0, sizeof(m_dcb));
-        memset(&m_timeouts, 0, sizeof(m_timeouts));
+#ifdef B921600
+            case 921600: return B921600;
 #endif
-    }
-
-    SerialPort::~SerialPort() {
-        close();
-    }
+#ifdef B1000000
+            case 1000000: return B1000000;
+#endif
+#ifdef B2000000
+            case 2000000: return B2000000;
+#endif
+#ifdef B3000000
+            case 3000000: return B3000000;
+#endif
+#ifdef B4000000
+            case 4000000: return B4000000;
+#endif
+            default: return 0;
+            }
+        }
 
-    bool SerialPort::open(const std::string& port, uint32_t baudRate) {
-        std::lock_guard<std::mutex> lock(m_mutex);
+#ifdef __linux__
+        // Mirror of the kernel's struct termios2; <asm/termbits.h> cannot be
+        // included next to <termios.h>, so the ioctl layout is declared here.
+        struct KernelTermios2 {
+            tcflag_t c_iflag;
+            tcflag_t c_oflag;
+            tcflag_t c_cflag;
+            tcflag_t c_lflag;
+            cc_t c_line;
+            cc_t c_cc[19];
+            speed_t c_ispeed;
+            speed_t c_ospeed;
+        };
+
+        constexpr tcflag_t KERNEL_CBAUD = 0010017;
+        constexpr tcflag_t KERNEL_BOTHER = 0010000;
+#endif
 
-        if (m_isOpen) {
-            close();
+        // Arbitrary baud rates via termios2/BOTHER (Linux) or IOSSIOSPEED (macOS)
+        bool setCustomBaudRate(int fd, uint32_t baudRate) {
+#if defined(__linux__)
+            KernelTermios2 tio{};
+            if (ioctl(fd, _IOR('T', 0x2A, KernelTermios2), &tio) != 0) {
+                return false;
+            }
+            tio.c_cflag &= ~KERNEL_CBAUD;
+            tio.c_cflag |= KERNEL_BOTHER;
+            tio.c_ispeed = baudRate;
+            tio.c_ospeed = baudRate;
+            return ioctl(fd, _IOW('T', 0x2B, KernelTermios2), &tio) == 0;
+#elif defined(__APPLE__)
+            speed_t speed = baudRate;
+            return ioctl(fd, IOSSIOSPEED, &speed) == 0;
+#else
+            (void)fd;
+            (void)baudRate;
+            return false;
+#endif
         }
 
-        m_portName = port;
-        m_baudRate = baudRate;
-
-#ifdef _WIN32
-        std::string fullPortName = "\\\\.\\" + port;
+#ifdef __linux__
+        // First line of a sysfs attribute, whitespace-trimmed ("" if missing)
+        std::string readSysfsAttribute(const std::string& path) {
+            std::ifstream file(path);
+            std::string value;
+            std::getline(file, value);
+            size_t end = value.find_last_not_of(" \t\r\n");
+            return end == std::string::npos ? "" : value.substr(0, end + 1);
+        }
 
-        m_handle = CreateFileA(
-            fullPortName.c_str(),
-            GENERIC_READ | GENERIC_WRITE,
-            0,
-            nullptr,
-            OPEN_EXISTING,
-            FILE_ATTRIBUTE_NORMAL,
-            nullptr
-        );
+        // /sys/class/tty/<name>/device points at the USB interface (cdc_acm)
+        // or the usb-serial port below it (ch341); the USB device that owns
+        // idVendor/idProduct/product is a few levels up
+        bool isMakcuTty(const std::string& ttyDir) {
+            char resolved[PATH_MAX];
+            if (!realpath((ttyDir + "/device").c_str(), resolved)) {
+                return false;
+            }
 
-        if (m_handle == INVALID_HANDLE_VALUE) {
+            std::string dir = resolved;
+            for (int depth = 0; depth < 4 && !dir.empty(); ++depth) {
+                std::string vendor = readSysfsAttribute(dir + "/idVendor");
+                if (!vendor.empty()) {
+                    uint16_t vid = static_cast<uint16_t>(std::strtoul(vendor.c_str(), nullptr, 16));
+                    uint16_t pid = static_cast<uint16_t>(std::strtoul(
+                        readSysfsAttribute(dir + "/idProduct").c_str(), nullptr, 16));
+                    std::string product = readSysfsAttribute(dir + "/product");
+                    return (vid == MAKCU_USB_VID && pid == MAKCU_USB_PID) ||
+                        product.find("CH343") != std::string::npos ||
+                        product.find("CH340") != std::string::npos;
+                }
+                dir.erase(dir.find_last_of('/'));
+            }
             return false;
         }
 
-        if (!configurePort()) {
-            CloseHandle(m_handle);
-            m_handle = INVALID_HANDLE_VALUE;
-            return false;
+        // tty names under <root>/class/tty that are backed by real hardware
+        std::vector<std::string> listSysfsTtys(const std::string& sysfsRoot, bool makcuOnly) {
+            std::vector<std::string> ports;
+            std::string classDir = sysfsRoot + "/class/tty";
+            DIR* dir = opendir(classDir.c_str());
+            if (!dir) {
+                return ports;
+            }
+
+            while (dirent* entry = readdir(dir)) {
+                if (entry->d_name[0] == '.') {
+                    continue;
+                }
+                std::string ttyDir = classDir + "/" + entry->d_name;
+                if (access((ttyDir + "/device").c_str(), F_OK) != 0) {
+                    continue;  // Virtual console / pty, no hardware behind it
+                }
+                if (!makcuOnly || isMakcuTty(ttyDir)) {
+                    ports.push_back(std::string("/dev/") + entry->d_name);
+                }
+            }
+            closedir(dir);
+            return ports;
         }
+#endif
 
-        m_isOpen = true;
+    } // namespace
+#endif
 
-        // Start high-performance listener thread
-        m_stopListener = false;
-        m_listenerThread = std::thread(&SerialPort::listenerLoop, this);
+    namespace {
 
-        return true;
+        uint64_t toNanoseconds(std::chrono::steady_clock::time_point tp) {
+            return static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch()).count());
+        }
+
+        // Listener-owned counters: single writer, so no locked RMW
+        void bumpCounter(std::atomic<uint64_t>& counter, uint64_t by = 1) {
+            counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+        }
+
+#if defined(MAKCU_SIMD_AVX2) || defined(MAKCU_SIMD_SSE2)
+        inline unsigned lowestSetBit(uint32_t mask) {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return static_cast<unsigned>(index);
 #else
-        return false; // Linux implementation would go here
+            return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+        }
 #endif
-    }
 
-    void SerialPort::close() {
-        std::lock_guard<std::mutex> lock(m_mutex);
+        // Index of the first byte < 32 (button mask, CR or LF) in [from, length),
+        // or length. Printable text is skipped 32 (AVX2) or 16 (SSE2) bytes at a
+        // time: x <= 31 exactly when max_epu8(x, 31) == 31
+        size_t findControlByte(const uint8_t* data, size_t from, size_t length) {
+            size_t i = from;
+#if defined(MAKCU_SIMD_AVX2)
+            const __m256i limit = _mm256_set1_epi8(31);
+            for (; i + 32 <= length; i += 32) {
+                __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+                    _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, limit), limit)));
+                if (mask) {
+                    return i + lowestSetBit(mask);
+                }
+            }
+#endif
+#if defined(MAKCU_SIMD_AVX2) || defined(MAKCU_SIMD_SSE2)
+            const __m128i limit16 = _mm_set1_epi8(31);
+            for (; i + 16 <= length; i += 16) {
+                __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(
+                    _mm_cmpeq_epi8(_mm_max_epu8(chunk, limit16), limit16)));
+                if (mask) {
+                    return i + lowestSetBit(mask);
+                }
+            }
+#endif
+            for (; i < length; ++i) {
+                if (data[i] < 32) {
+                    return i;
+                }
+            }
+            return length;
+        }
 
-        if (!m_isOpen) {
-            return;
+        int32_t saturate(int64_t value) {
+            return static_cast<int32_t>(std::clamp<int64_t>(value,
+                std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max()));
         }
 
-        // Stop listener thread
-        m_stopListener = true;
-        if (m_listenerThread.joinable()) {
-            m_listenerThread.join();
+        // "<name>(a,b,...)\r\n" with up to five integer arguments; the caller
+        // guarantees CommandEncoder::MAX_TEXT_COMMAND bytes at out
+        size_t formatCall(char* out, std::string_view name, const int64_t* args, size_t count) {
+            constexpr size_t INT_DIGITS = 11;  // "-2147483648", "4294967295"
+            char* p = out;
+            memcpy(p, name.data(), name.size());
+            p += name.size();
+            *p++ = '(';
+            for (size_t i = 0; i < count; ++i) {
+                if (i > 0) {
+                    *p++ = ',';
+                }
+                p = std::to_chars(p, p + INT_DIGITS, args[i]).ptr;
+            }
+            memcpy(p, ")\r\n", 3);
+            return static_cast<size_t>(p + 3 - out);
         }
 
-        // Cancel all pending commands
-        {
-            std::lock_guard<std::mutex> cmdLock(m_commandMutex);
-            for (auto& [id, cmd] : m_pendingCommands) {
-                try {
-                    cmd->promise.set_exception(std::make_exception_ptr(
-                        std::runtime_error("Connection closed")));
+        void appendCommand(std::vector<char>& out, const OutboundCommand& command, const CommandEncoder& encoder) {
+            if (command.kind == OutboundCommand::Kind::Raw) {
+                out.insert(out.end(), command.data(), command.data() + command.length);
+            }
+            else if (command.kind == OutboundCommand::Kind::Move) {
+                encoder.appendMove(out, command.x, command.y);
+            }
+            else {
+                encoder.appendWheel(out, command.x);
+            }
+        }
+
+        // Per-thread buffer for encoding typed commands off the writer thread;
+        // it keeps its capacity, so only a thread's first command allocates
+        std::vector<char>& encodeScratch() {
+            thread_local std::vector<char> scratch;
+            scratch.clear();
+            return scratch;
+        }
+
+        // Class of a text command by its name; anything unrecognised (info,
+        // configuration) shares the lowest class with queries
+        CommandPriority classifyCommand(std::string_view command) {
+            constexpr std::string_view CONTROL_PREFIXES[] = {
+                "km.left(", "km.right(", "km.middle(", "km.ms1(", "km.ms2(", "km.buttons(", "km.lock_" };
+            constexpr std::string_view MOTION_PREFIXES[] = { "km.move(", "km.wheel(" };
+
+            for (std::string_view prefix : CONTROL_PREFIXES) {
+                if (command.substr(0, prefix.size()) == prefix) {
+                    return CommandPriority::CONTROL;
+                }
+            }
+            for (std::string_view prefix : MOTION_PREFIXES) {
+                if (command.substr(0, prefix.size()) == prefix) {
+                    return CommandPriority::MOTION;
                 }
-                catch (...) {
-                    // Promise already set
+            }
+            return CommandPriority::QUERY;
+        }
+
+        constexpr const char* BUTTON_NAMES[] = { "left", "right", "middle", "ms1", "ms2" };
+        constexpr size_t BUTTON_COUNT = sizeof(BUTTON_NAMES) / sizeof(BUTTON_NAMES[0]);
+
+        // Press/release bit (1 << MouseButton) of a km.<button>(1|0) command
+        void buttonTransition(std::string_view command, uint8_t& presses, uint8_t& releases) {
+            constexpr std::string_view PREFIX = "km.";
+            if (command.substr(0, PREFIX.size()) != PREFIX) {
+                return;
+            }
+            command.remove_prefix(PREFIX.size());
+            for (size_t index = 0; index < BUTTON_COUNT; ++index) {
+                std::string_view name = BUTTON_NAMES[index];
+                if (command.size() == name.size() + 3 && command.substr(0, name.size()) == name &&
+                    command[name.size()] == '(' && command.back() == ')') {
+                    uint8_t bit = static_cast<uint8_t>(1u << index);
+                    if (command[name.size() + 1] == '1') {
+                        presses = static_cast<uint8_t>(presses | bit);
+                        releases = static_cast<uint8_t>(releases & ~bit);
+                    }
+                    else if (command[name.size() + 1] == '0') {
+                        releases = static_cast<uint8_t>(releases | bit);
+                        presses = static_cast<uint8_t>(presses & ~bit);
+                    }
+                    return;
                 }
             }
-            m_pendingCommands.clear();
         }
 
+        class AsciiEncoder final : public CommandEncoder {
+        public:
+            WireProtocol protocol() const override { return WireProtocol::ASCII; }
+
+            void appendMove(std::vector<char>& out, int32_t dx, int32_t dy) const override {
+                char line[MAX_TEXT_COMMAND];
+                out.insert(out.end(), line, line + formatMove(line, dx, dy));
+            }
+
+            void appendWheel(std::vector<char>& out, int32_t delta) const override {
+                char line[MAX_TEXT_COMMAND];
+                out.insert(out.end(), line, line + formatWheel(line, delta));
+            }
+
+            bool appendButton(std::vector<char>& out, MouseButton button, bool pressed) const override {
+                // "km.left(1)\r\n"
+                size_t index = static_cast<size_t>(button);
+                if (index >= BUTTON_COUNT) {
+                    return false;
+                }
+                const char* name = BUTTON_NAMES[index];
+                out.insert(out.end(), { 'k', 'm', '.' });
+                out.insert(out.end(), name, name + std::strlen(name));
+                out.insert(out.end(), { '(', pressed ? '1' : '0', ')', '\r', '\n' });
+                return true;
+            }
+        };
+
+        // Frames: DE AD | u16 LE (opcode + payload) | opcode | payload (LE)
+        //   move   0xB1  i16 dx, i16 dy   9 bytes
+        //   wheel  0xB2  i16 delta        7 bytes
+        //   button 0xB3  u8 button, u8 state  7 bytes
+        // Deltas beyond int16 are split across frames so the sum is preserved
+        class BinaryFrameEncoder final : public CommandEncoder {
+        public:
+            static constexpr uint8_t OP_MOVE = 0xB1;
+            static constexpr uint8_t OP_WHEEL = 0xB2;
+            static constexpr uint8_t OP_BUTTON = 0xB3;
+
+            WireProtocol protocol() const override { return WireProtocol::BINARY; }
+
+            void appendMove(std::vector<char>& out, int32_t dx, int32_t dy) const override {
+                int64_t x = dx;
+                int64_t y = dy;
+                do {
+                    int16_t stepX = clampStep(x);
+                    int16_t stepY = clampStep(y);
+                    const uint8_t payload[4] = { lo(stepX), hi(stepX), lo(stepY), hi(stepY) };
+                    appendFrame(out, OP_MOVE, payload, sizeof(payload));
+                    x -= stepX;
+                    y -= stepY;
+                } while (x != 0 || y != 0);
+            }
+
+            void appendWheel(std::vector<char>& out, int32_t delta) const override {
+                int64_t remaining = delta;
+                do {
+                    int16_t step = clampStep(remaining);
+                    const uint8_t payload[2] = { lo(step), hi(step) };
+                    appendFrame(out, OP_WHEEL, payload, sizeof(payload));
+                    remaining -= step;
+                } while (remaining != 0);
+            }
+
+            bool appendButton(std::vector<char>& out, MouseButton button, bool pressed) const override {
+                if (static_cast<size_t>(button) >= BUTTON_COUNT) {
+                    return false;
+                }
+                const uint8_t payload[2] = { static_cast<uint8_t>(button), static_cast<uint8_t>(pressed ? 1 : 0) };
+                appendFrame(out, OP_BUTTON, payload, sizeof(payload));
+                return true;
+            }
+
+        private:
+            static int16_t clampStep(int64_t value) {
+                return static_cast<int16_t>(std::clamp<int64_t>(value,
+                    std::numeric_limits<int16_t>::min(), std::numeric_limits<int16_t>::max()));
+            }
+            static uint8_t lo(int16_t value) { return static_cast<uint8_t>(static_cast<uint16_t>(value) & 0xFF); }
+            static uint8_t hi(int16_t value) { return static_cast<uint8_t>(static_cast<uint16_t>(value) >> 8); }
+
+            static void appendFrame(std::vector<char>& out, uint8_t opcode, const uint8_t* payload, size_t size) {
+                size_t length = size + 1;
+                char header[5] = { '\xDE', '\xAD', static_cast<char>(length & 0xFF),
+                    static_cast<char>(length >> 8), static_cast<char>(opcode) };
+                out.insert(out.end(), header, header + sizeof(header));
+                out.insert(out.end(), reinterpret_cast<const char*>(payload),
+                    reinterpret_cast<const char*>(payload) + size);
+            }
+        };
+
+        // Real-time helpers for the calling thread; each returns false where
+        // the OS refuses (missing privilege, offline CPU, unsupported platform)
+        constexpr size_t PREFAULT_STACK_BYTES = 64 * 1024;
+
+        // cpu < 0 restores the process-wide mask
+        bool pinCurrentThread(int cpu) {
 #ifdef _WIN32
-        if (m_handle != INVALID_HANDLE_VALUE) {
-            CloseHandle(m_handle);
-            m_handle = INVALID_HANDLE_VALUE;
+            DWORD_PTR processMask, systemMask;
+            if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask) ||
+                cpu >= static_cast<int>(sizeof(DWORD_PTR) * 8)) {
+                return false;
+            }
+            DWORD_PTR mask = cpu < 0 ? processMask : (static_cast<DWORD_PTR>(1) << cpu);
+            return SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#elif defined(__linux__)
+            if (cpu >= CPU_SETSIZE) {
+                return false;
+            }
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            if (cpu < 0) {
+                long cpus = sysconf(_SC_NPROCESSORS_CONF);
+                for (long i = 0; i < cpus && i < CPU_SETSIZE; ++i) {
+                    CPU_SET(i, &set);
+                }
+            }
+            else {
+                CPU_SET(cpu, &set);
+            }
+            return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+            return cpu < 0;
+#endif
         }
+
+        // priority 1-99 selects SCHED_FIFO (TIME_CRITICAL on Windows), 0 the default policy
+        bool setCurrentThreadPriority(int priority) {
+#ifdef _WIN32
+            return SetThreadPriority(GetCurrentThread(),
+                priority > 0 ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_NORMAL) != 0;
 #else
-        if (m_fd >= 0) {
-            ::close(m_fd);
-            m_fd = -1;
+            int policy = priority > 0 ? SCHED_FIFO : SCHED_OTHER;
+            sched_param param{};
+            param.sched_priority = priority > 0
+                ? std::clamp(priority, sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO))
+                : 0;
+            return pthread_setschedparam(pthread_self(), policy, &param) == 0;
+#endif
         }
+
+        // Process-wide: locks current and future mappings, which also
+        // populates them
+        bool lockProcessMemory(bool enable) {
+#ifdef _WIN32
+            (void)enable;
+            return false;
+#else
+            return enable ? mlockall(MCL_CURRENT | MCL_FUTURE) == 0 : munlockall() == 0;
 #endif
+        }
 
-        m_isOpen = false;
+        // Touch the stack the thread's hot path runs on so the first event
+        // after an idle period does not take page faults
+        void prefaultStack() {
+            volatile char stack[PREFAULT_STACK_BYTES];
+            for (size_t i = 0; i < sizeof(stack); i += 4096) {
+                stack[i] = 0;
+            }
+        }
+
+    } // namespace
+
+    const CommandEncoder& CommandEncoder::forProtocol(WireProtocol protocol) {
+        static const AsciiEncoder ascii;
+        static const BinaryFrameEncoder binary;
+        if (protocol == WireProtocol::BINARY) {
+            return binary;
+        }
+        return ascii;
     }
 
-    bool SerialPort::isOpen() const {
-        return m_isOpen;
+    size_t CommandEncoder::formatMove(char* out, int32_t dx, int32_t dy) {
+        const int64_t args[] = { dx, dy };
+        return formatCall(out, "km.move", args, 2);
     }
 
-    std::future<std::string> SerialPort::sendTrackedCommand(const std::string& command,
-        bool expectResponse,
-        std::chrono::milliseconds timeout) {
-        if (!m_isOpen) {
-            std::promise<std::string> promise;
-            promise.set_exception(std::make_exception_ptr(
-                std::runtime_error("Port not open")));
-            return promise.get_future();
-        }
+    size_t CommandEncoder::formatMove(char* out, int32_t dx, int32_t dy, uint32_t segments) {
+        const int64_t args[] = { dx, dy, segments };
+        return formatCall(out, "km.move", args, 3);
+    }
 
-        int cmdId = generateCommandId();
-        auto pendingCmd = std::make_unique<PendingCommand>(cmdId, command, expectResponse, timeout);
-        auto future = pendingCmd->promise.get_future();
+    size_t CommandEncoder::formatMove(char* out, int32_t dx, int32_t dy, uint32_t segments, int32_t cx, int32_t cy) {
+        const int64_t args[] = { dx, dy, segments, cx, cy };
+        return formatCall(out, "km.move", args, 5);
+    }
 
-        // Store pending command
-        {
-            std::lock_guard<std::mutex> lock(m_commandMutex);
-            m_pendingCommands[cmdId] = std::move(pendingCmd);
-        }
+    size_t CommandEncoder::formatWheel(char* out, int32_t delta) {
+        const int64_t args[] = { delta };
+        return formatCall(out, "km.wheel", args, 1);
+    }
 
-        // Send command with ID tracking
-        std::string trackedCommand = expectResponse ?
-            command + "#" + std::to_string(cmdId) + "\r\n" :
-            command + "\r\n";
+    // WakeSignal implementation
+    bool WakeSignal::create() {
+        destroy();
+#ifdef _WIN32
+        m_event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+        return m_event != nullptr;
+#elif defined(__linux__)
+        m_fds[0] = m_fds[1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        return m_fds[0] >= 0;
+#else
+        if (pipe(m_fds) != 0) {
+            m_fds[0] = m_fds[1] = -1;
+            return false;
+        }
+        for (int fd : m_fds) {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+        return true;
+#endif
+    }
 
+    void WakeSignal::destroy() {
 #ifdef _WIN32
-        DWORD bytesWritten = 0;
-        bool success = WriteFile(m_handle, trackedCommand.c_str(),
-            static_cast<DWORD>(trackedCommand.length()),
-            &bytesWritten, nullptr);
+        if (m_event) {
+            CloseHandle(m_event);
+            m_event = nullptr;
+        }
+#else
+        if (m_fds[1] >= 0 && m_fds[1] != m_fds[0]) {
+            ::close(m_fds[1]);
+        }
+        if (m_fds[0] >= 0) {
+            ::close(m_fds[0]);
+        }
+        m_fds[0] = m_fds[1] = -1;
+#endif
+    }
 
-        if (!success || bytesWritten != trackedCommand.length()) {
-            std::lock_guard<std::mutex> lock(m_commandMutex);
-            auto it = m_pendingCommands.find(cmdId);
-            if (it != m_pendingCommands.end()) {
-                try {
-                    it->second->promise.set_exception(std::make_exception_ptr(
-                        std::runtime_error("Write failed")));
-                }
-                catch (...) {
-                    // Promise already set
-                }
-                m_pendingCommands.erase(it);
-            }
+    void WakeSignal::signal() {
+#ifdef _WIN32
+        if (m_event) {
+            SetEvent(m_event);
+        }
+#else
+        if (m_fds[1] >= 0) {
+            uint64_t one = 1;
+            ssize_t ignored = ::write(m_fds[1], &one, sizeof(one));
+            (void)ignored;
         }
+#endif
+    }
 
-        FlushFileBuffers(m_handle);
+    void WakeSignal::drain() {
+#ifndef _WIN32
+        // Auto-reset events need no draining on Windows
+        uint64_t value;
+        while (m_fds[0] >= 0 && ::read(m_fds[0], &value, sizeof(value)) > 0) {
+        }
 #endif
+    }
 
-        return future;
+    // DeadlineTimer implementation
+    bool DeadlineTimer::create() {
+        destroy();
+#ifdef _WIN32
+        m_timer = CreateWaitableTimerExW(nullptr, nullptr,
+            CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+        if (!m_timer) {
+            // Pre-1803 Windows: fall back to a regular waitable timer
+            m_timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+        }
+        return m_timer != nullptr;
+#elif defined(__linux__)
+        m_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        return m_fd >= 0;
+#else
+        return true;
+#endif
     }
 
-    bool SerialPort::sendCommand(const std::string& command) {
-        if (!m_isOpen) {
-            return false;
+    void DeadlineTimer::destroy() {
+#ifdef _WIN32
+        if (m_timer) {
+            CloseHandle(m_timer);
+            m_timer = nullptr;
+        }
+#else
+        if (m_fd >= 0) {
+            ::close(m_fd);
+            m_fd = -1;
         }
+#endif
+    }
 
-        std::string fullCommand = command + "\r\n";
+    void DeadlineTimer::wait(WakeSignal& wake, TimePoint deadline) {
+        bool armed = deadline != TimePoint::max();
+        auto now = std::chrono::steady_clock::now();
+        if (armed && deadline <= now) {
+            return;
+        }
 
 #ifdef _WIN32
-        DWORD bytesWritten = 0;
-        bool success = WriteFile(m_handle, fullCommand.c_str(),
-            static_cast<DWORD>(fullCommand.length()),
-            &bytesWritten, nullptr);
+        DWORD count = 1;
+        HANDLE handles[2] = { wake.handle(), m_timer };
+        if (armed && m_timer) {
+            // Negative due time = relative, in 100ns units
+            auto ticks = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now).count() / 100;
+            LARGE_INTEGER due;
+            due.QuadPart = -std::max<long long>(ticks, 1);
+            SetWaitableTimer(m_timer, &due, 0, nullptr, nullptr, FALSE);
+            count = 2;
+        }
+        WaitForMultipleObjects(count, handles, FALSE, INFINITE);
+        if (count == 2) {
+            CancelWaitableTimer(m_timer);
+        }
+#elif defined(__linux__)
+        // steady_clock is CLOCK_MONOTONIC, so the deadline arms the timerfd directly
+        itimerspec spec{};
+        if (armed) {
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+            spec.it_value.tv_sec = static_cast<time_t>(ns / 1000000000);
+            spec.it_value.tv_nsec = static_cast<long>(ns % 1000000000);
+        }
+        timerfd_settime(m_fd, TFD_TIMER_ABSTIME, &spec, nullptr);
 
-        if (success && bytesWritten == fullCommand.length()) {
-            FlushFileBuffers(m_handle);
-            return true;
+        pollfd fds[2] = {
+            { wake.fd(), POLLIN, 0 },
+            { m_fd, POLLIN, 0 }
+        };
+        ::poll(fds, armed ? 2 : 1, -1);
+
+        uint64_t expirations;
+        while (::read(m_fd, &expirations, sizeof(expirations)) > 0) {
+        }
+        wake.drain();
+#else
+        // No timerfd: millisecond poll() timeout, rounded up
+        int timeoutMs = -1;
+        if (armed) {
+            auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(deadline - now).count();
+            timeoutMs = static_cast<int>((remaining + 999) / 1000);
         }
+        pollfd pfd{ wake.fd(), POLLIN, 0 };
+        ::poll(&pfd, 1, timeoutMs);
+        wake.drain();
 #endif
+    }
 
-        return false;
+    // IoUring implementation
+#ifdef MAKCU_IO_URING
+    namespace {
+
+        constexpr unsigned URING_ENTRIES = 16;
+        constexpr unsigned URING_SQPOLL_IDLE_MS = 10;        // Kernel SQ thread sleeps after this
+        constexpr size_t URING_PENDING_LIMIT = 64 * 1024;   // Coalesced bytes before write() waits
+        constexpr uint64_t URING_READ = 1;
+        constexpr uint64_t URING_WRITE = 2;
+        constexpr uint64_t URING_CANCEL = 3;
+        constexpr std::chrono::milliseconds URING_REAPER_INTERVAL(1000);
+
+        int ioUringSetup(unsigned entries, io_uring_params* params) {
+            return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+        }
+
+        int ioUringEnter(int ringFd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+            return static_cast<int>(::syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+        }
+
+        // IORING_REGISTER_PROBE itself needs 5.6, the same as READ/WRITE
+        bool supportsRequiredOps(int ringFd) {
+            constexpr unsigned OPS = 256;
+            std::vector<char> buffer(sizeof(io_uring_probe) + OPS * sizeof(io_uring_probe_op), 0);
+            auto* probe = reinterpret_cast<io_uring_probe*>(buffer.data());
+            if (::syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PROBE, probe, OPS) < 0) {
+                return false;
+            }
+            for (unsigned op : { IORING_OP_READ, IORING_OP_WRITE, IORING_OP_ASYNC_CANCEL }) {
+                if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        template<typename T>
+        T* ringField(void* ring, uint32_t offset) {
+            return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+        }
+
+    } // namespace
+
+    bool IoUring::available() {
+        static const bool supported = [] {
+            io_uring_params params{};
+            int ringFd = ioUringSetup(2, &params);
+            if (ringFd < 0) {
+                return false;  // ENOSYS, or disabled by kernel.io_uring_disabled / seccomp
+            }
+            bool ok = supportsRequiredOps(ringFd);
+            ::close(ringFd);
+            return ok;
+        }();
+        return supported;
+    }
+
+    bool IoUring::create(int fd, size_t readSize, bool sqPoll) {
+        destroy();
+
+        // SQPOLL first; before 5.11 it needs privileges and registered
+        // files, in which case the plain ring is used
+        io_uring_params params{};
+        if (sqPoll) {
+            params.flags = IORING_SETUP_SQPOLL;
+            params.sq_thread_idle = URING_SQPOLL_IDLE_MS;
+            m_ringFd = ioUringSetup(URING_ENTRIES, &params);
+            if (m_ringFd >= 0 && !(params.features & IORING_FEAT_SQPOLL_NONFIXED)) {
+                ::close(m_ringFd);
+                m_ringFd = -1;
+            }
+        }
+        m_sqPoll = m_ringFd >= 0;
+        if (m_ringFd < 0) {
+            params = io_uring_params{};
+            m_ringFd = ioUringSetup(URING_ENTRIES, &params);
+        }
+        if (m_ringFd < 0) {
+            return false;
+        }
+
+        if (!supportsRequiredOps(m_ringFd) || !mapRings(&params)) {
+            destroy();
+            return false;
+        }
+
+        m_fd = fd;
+        m_readBuffer.assign(readSize, 0);
+        m_inFlight.reserve(readSize);
+        m_pending.reserve(readSize);
+        m_writeFailed = false;
+        return true;
+    }
+
+    bool IoUring::mapRings(const void* rawParams) {
+        const auto& params = *static_cast<const io_uring_params*>(rawParams);
+        m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single) {
+            m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+        }
+
+        void* sq = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            m_ringFd, IORING_OFF_SQ_RING);
+        if (sq == MAP_FAILED) {
+            return false;
+        }
+        m_sqRing = sq;
+
+        if (single) {
+            m_cqRing = m_sqRing;
+        }
+        else {
+            void* cq = mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                m_ringFd, IORING_OFF_CQ_RING);
+            if (cq == MAP_FAILED) {
+                return false;
+            }
+            m_cqRing = cq;
+        }
+
+        m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            m_ringFd, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) {
+            return false;
+        }
+        m_sqes = sqes;
+
+        m_sqHead = ringField<unsigned>(m_sqRing, params.sq_off.head);
+        m_sqTail = ringField<unsigned>(m_sqRing, params.sq_off.tail);
+        m_sqFlags = ringField<unsigned>(m_sqRing, params.sq_off.flags);
+        m_sqArray = ringField<unsigned>(m_sqRing, params.sq_off.array);
+        m_sqMask = *ringField<unsigned>(m_sqRing, params.sq_off.ring_mask);
+        m_sqEntries = params.sq_entries;
+        m_cqHead = ringField<unsigned>(m_cqRing, params.cq_off.head);
+        m_cqTail = ringField<unsigned>(m_cqRing, params.cq_off.tail);
+        m_cqMask = *ringField<unsigned>(m_cqRing, params.cq_off.ring_mask);
+        m_cqes = ringField<void>(m_cqRing, params.cq_off.cqes);
+        return true;
+    }
+
+    bool IoUring::destroy(std::chrono::milliseconds timeout) {
+        if (m_ringFd < 0) {
+            return true;
+        }
+
+        if (m_sqes) {
+            // Queued writes go out first, then the armed read is cancelled;
+            // past the timeout a stuck write is cancelled too. The buffers
+            // they point at may only go once the kernel posted them, so if
+            // that takes another timeout the ring is left intact for a later
+            // call. Nobody else reaps now, so completions are consumed here
+            auto deadline = std::chrono::steady_clock::now() + timeout;
+            auto giveUp = deadline + timeout;
+            bool readCancelSent = false;
+            bool writeCancelSent = false;
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (m_writeInFlight || m_readArmed) {
+                auto now = std::chrono::steady_clock::now();
+                if (now >= giveUp) {
+                    return false;
+                }
+                bool expired = now >= deadline;
+                if (expired) {
+                    m_pending.clear();
+                }
+                if (m_readArmed && !readCancelSent && (!m_writeInFlight || expired)) {
+                    readCancelSent = submitCancelLocked(URING_READ);
+                }
+                if (m_writeInFlight && expired && !writeCancelSent) {
+                    writeCancelSent = submitCancelLocked(URING_WRITE);
+                }
+
+                auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    (expired ? giveUp : deadline) - now).count();
+                lock.unlock();
+                pollfd pfd{ m_ringFd, POLLIN, 0 };
+                ::poll(&pfd, 1, static_cast<int>(std::max<int64_t>(remaining, 1)));
+                lock.lock();
+
+                Completion batch[URING_ENTRIES];
+                size_t count = takeCompletions(batch, URING_ENTRIES);
+                for (size_t i = 0; i < count; ++i) {
+                    if (batch[i].tag == URING_WRITE) {
+                        if (expired) {
+                            m_writeInFlight = false;  // Nothing more goes out
+                        }
+                        else {
+                            completeWriteLocked(batch[i].result);
+                        }
+                    }
+                    else if (batch[i].tag == URING_READ) {
+                        m_readArmed = false;
+                    }
+                }
+            }
+
+            m_inFlight.clear();
+            m_pending.clear();
+        }
+
+        if (m_sqes) {
+            munmap(m_sqes, m_sqesSize);
+        }
+        if (m_cqRing && m_cqRing != m_sqRing) {
+            munmap(m_cqRing, m_cqRingSize);
+        }
+        if (m_sqRing) {
+            munmap(m_sqRing, m_sqRingSize);
+        }
+        m_sqes = m_cqRing = m_sqRing = nullptr;
+        ::close(m_ringFd);
+        m_ringFd = -1;
+        m_fd = -1;
+        m_toSubmit = 0;
+        m_writeDone.notify_all();
+        return true;
+    }
+
+    IoUring::~IoUring() {
+        if (destroy()) {
+            return;
+        }
+        // The kernel may still write into our buffers: a heap copy of the
+        // ring is finished by the reaper instead of blocking the owner
+        auto orphan = std::make_unique<IoUring>();
+        orphan->takeOver(*this);
+        retire(std::move(orphan), std::chrono::milliseconds(0));
+    }
+
+    // Only for a ring nobody else touches any more (destructor hand-off)
+    void IoUring::takeOver(IoUring& other) {
+        std::lock_guard<std::mutex> lock(other.m_mutex);
+        m_fd = std::exchange(other.m_fd, -1);
+        m_ringFd = std::exchange(other.m_ringFd, -1);
+        m_sqPoll = other.m_sqPoll;
+        m_sqRing = std::exchange(other.m_sqRing, nullptr);
+        m_cqRing = std::exchange(other.m_cqRing, nullptr);
+        m_sqes = std::exchange(other.m_sqes, nullptr);
+        m_sqRingSize = other.m_sqRingSize;
+        m_cqRingSize = other.m_cqRingSize;
+        m_sqesSize = other.m_sqesSize;
+        m_sqHead = other.m_sqHead;
+        m_sqTail = other.m_sqTail;
+        m_sqFlags = other.m_sqFlags;
+        m_sqArray = other.m_sqArray;
+        m_sqMask = other.m_sqMask;
+        m_sqEntries = other.m_sqEntries;
+        m_cqHead = other.m_cqHead;
+        m_cqTail = other.m_cqTail;
+        m_cqMask = other.m_cqMask;
+        m_cqes = other.m_cqes;
+        m_toSubmit = std::exchange(other.m_toSubmit, 0);
+        m_readBuffer.swap(other.m_readBuffer);
+        m_readArmed = std::exchange(other.m_readArmed, false);
+        m_inFlight.swap(other.m_inFlight);
+        m_inFlightOffset = std::exchange(other.m_inFlightOffset, 0);
+        m_writeInFlight = std::exchange(other.m_writeInFlight, false);
+        m_pending.swap(other.m_pending);
+        m_writeFailed = other.m_writeFailed;
+    }
+
+    void IoUring::retire(std::unique_ptr<IoUring> ring, std::chrono::milliseconds timeout) {
+        if (!ring || ring->destroy(timeout)) {
+            return;
+        }
+        // Typically a write wedged on a stalled tty: it ends once the device
+        // drains or hangs up, and only then may the buffers be freed
+        std::thread([ring = std::move(ring)] {
+            while (!ring->destroy(URING_REAPER_INTERVAL)) {
+            }
+            }).detach();
+    }
+
+    bool IoUring::hasCompletions() const {
+        return m_ringFd >= 0 &&
+            __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE) != __atomic_load_n(m_cqHead, __ATOMIC_RELAXED);
+    }
+
+    // Caller holds m_mutex
+    void* IoUring::nextSqe() {
+        unsigned tail = *m_sqTail;
+        if (tail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE) >= m_sqEntries) {
+            return nullptr;
+        }
+        auto* sqe = static_cast<io_uring_sqe*>(m_sqes) + (tail & m_sqMask);
+        memset(sqe, 0, sizeof(*sqe));
+        m_sqArray[tail & m_sqMask] = tail & m_sqMask;
+        return sqe;
+    }
+
+    void IoUring::commitSqe() {
+        __atomic_store_n(m_sqTail, *m_sqTail + 1, __ATOMIC_RELEASE);
+        ++m_toSubmit;
+    }
+
+    // SQPOLL: the kernel thread picks the entry up, a syscall is needed only
+    // to wake it after an idle period. Otherwise one io_uring_enter
+    // Caller holds m_mutex
+    bool IoUring::submitCancelLocked(uint64_t target) {
+        auto* sqe = static_cast<io_uring_sqe*>(nextSqe());
+        if (!sqe) {
+            return false;
+        }
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->addr = target;
+        sqe->user_data = URING_CANCEL;
+        commitSqe();
+        return submitLocked();
+    }
+
+    bool IoUring::submitLocked() {
+        if (m_toSubmit == 0) {
+            return true;
+        }
+        if (m_sqPoll) {
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            if (__atomic_load_n(m_sqFlags, __ATOMIC_RELAXED) & IORING_SQ_NEED_WAKEUP) {
+                ioUringEnter(m_ringFd, 0, 0, IORING_ENTER_SQ_WAKEUP);
+            }
+            m_toSubmit = 0;
+            return true;
+        }
+
+        int submitted;
+        do {
+            submitted = ioUringEnter(m_ringFd, m_toSubmit, 0, 0);
+        } while (submitted < 0 && errno == EINTR);
+        if (submitted < 0) {
+            return false;
+        }
+        m_toSubmit -= std::min<unsigned>(static_cast<unsigned>(submitted), m_toSubmit);
+        return true;
+    }
+
+    bool IoUring::armRead() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto* sqe = static_cast<io_uring_sqe*>(nextSqe());
+        if (!sqe) {
+            return false;
+        }
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = m_fd;
+        sqe->addr = reinterpret_cast<uint64_t>(m_readBuffer.data());
+        sqe->len = static_cast<uint32_t>(m_readBuffer.size());
+        sqe->off = static_cast<uint64_t>(-1);  // Current position (ttys have none)
+        sqe->user_data = URING_READ;
+        commitSqe();
+        m_readArmed = submitLocked();
+        return m_readArmed;
+    }
+
+    // Caller holds m_mutex
+    bool IoUring::submitWriteLocked() {
+        auto* sqe = static_cast<io_uring_sqe*>(nextSqe());
+        if (!sqe) {
+            return false;
+        }
+        sqe->opcode = IORING_OP_WRITE;
+        sqe->fd = m_fd;
+        sqe->addr = reinterpret_cast<uint64_t>(m_inFlight.data() + m_inFlightOffset);
+        sqe->len = static_cast<uint32_t>(m_inFlight.size() - m_inFlightOffset);
+        sqe->off = static_cast<uint64_t>(-1);
+        sqe->user_data = URING_WRITE;
+        commitSqe();
+        m_writeInFlight = submitLocked();
+        return m_writeInFlight;
+    }
+
+    void IoUring::completeWriteLocked(int32_t result) {
+        if (result == -EINTR || result == -EAGAIN) {
+            if (submitWriteLocked()) {
+                return;
+            }
+            result = -EIO;
+        }
+        if (result < 0) {
+            m_writeFailed = true;
+            m_writeInFlight = false;
+            m_inFlight.clear();
+            m_pending.clear();
+            m_writeDone.notify_all();
+            return;
+        }
+
+        m_inFlightOffset += static_cast<size_t>(result);
+        if (m_inFlightOffset < m_inFlight.size() && submitWriteLocked()) {
+            return;  // Short write: the rest goes out next
+        }
+
+        m_inFlight.clear();
+        m_inFlightOffset = 0;
+        m_writeInFlight = false;
+        if (!m_pending.empty()) {
+            m_inFlight.swap(m_pending);
+            submitWriteLocked();
+        }
+        m_writeDone.notify_all();
+    }
+
+    bool IoUring::write(const char* data, size_t length, std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_ringFd < 0 || m_writeFailed) {
+            return false;
+        }
+        if (!m_writeInFlight) {
+            m_inFlight.assign(data, data + length);
+            m_inFlightOffset = 0;
+            return submitWriteLocked();
+        }
+
+        // Coalesce behind the write in flight; wait only if far behind
+        if (m_pending.size() + length > URING_PENDING_LIMIT &&
+            !m_writeDone.wait_for(lock, timeout, [&] {
+                return m_writeFailed || m_pending.size() + length <= URING_PENDING_LIMIT;
+                })) {
+            return false;
+        }
+        if (m_writeFailed) {
+            return false;
+        }
+        if (!m_writeInFlight) {
+            m_inFlight.assign(data, data + length);
+            m_inFlightOffset = 0;
+            return submitWriteLocked();
+        }
+        m_pending.insert(m_pending.end(), data, data + length);
+        return true;
+    }
+
+    bool IoUring::waitWritesIdle(std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_writeDone.wait_for(lock, timeout, [this] {
+            return m_ringFd < 0 || m_writeFailed || (!m_writeInFlight && m_pending.empty());
+            }) && !m_writeFailed && m_ringFd >= 0;
+    }
+
+    // Caller holds m_mutex
+    size_t IoUring::takeCompletions(Completion* out, size_t max) {
+        unsigned head = *m_cqHead;
+        unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+        size_t count = 0;
+        while (head != tail && count < max) {
+            const auto& cqe = static_cast<const io_uring_cqe*>(m_cqes)[head & m_cqMask];
+            out[count++] = Completion{ cqe.user_data, cqe.res };
+            ++head;
+        }
+        __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+        return count;
+    }
+
+    bool IoUring::reap(const std::function<void(const uint8_t*, size_t)>& onRead) {
+        while (true) {
+            Completion batch[URING_ENTRIES];
+            size_t count;
+            bool readDone = false;
+            int32_t readResult = 0;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                count = takeCompletions(batch, URING_ENTRIES);
+                for (size_t i = 0; i < count; ++i) {
+                    if (batch[i].tag == URING_WRITE) {
+                        completeWriteLocked(batch[i].result);
+                    }
+                    else if (batch[i].tag == URING_READ) {
+                        m_readArmed = false;
+                        readDone = true;
+                        readResult = batch[i].result;
+                    }
+                }
+            }
+            if (count == 0) {
+                return true;
+            }
+            if (!readDone) {
+                continue;
+            }
+
+            // Blocking read with VMIN = 1: 0 bytes means hangup
+            if (readResult > 0) {
+                onRead(m_readBuffer.data(), static_cast<size_t>(readResult));
+            }
+            else if (readResult != -EINTR && readResult != -EAGAIN) {
+                return false;
+            }
+            if (!armRead()) {
+                return false;
+            }
+        }
+    }
+#else
+    bool IoUring::available() { return false; }
+    bool IoUring::create(int, size_t, bool) { return false; }
+    IoUring::~IoUring() = default;
+    bool IoUring::destroy(std::chrono::milliseconds) { return true; }
+    void IoUring::retire(std::unique_ptr<IoUring>, std::chrono::milliseconds) {}
+    bool IoUring::hasCompletions() const { return false; }
+    bool IoUring::armRead() { return false; }
+    bool IoUring::write(const char*, size_t, std::chrono::milliseconds) { return false; }
+    bool IoUring::waitWritesIdle(std::chrono::milliseconds) { return false; }
+    bool IoUring::reap(const std::function<void(const uint8_t*, size_t)>&) { return false; }
+#endif
+
+    // CommandQueue implementation
+    CommandQueue::CommandQueue() {
+        for (size_t i = 0; i < CAPACITY; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    OutboundCommand* CommandQueue::front() {
+        Cell& cell = m_cells[m_dequeuePos & (CAPACITY - 1)];
+        if (cell.sequence.load(std::memory_order_acquire) != m_dequeuePos + 1) {
+            return nullptr;
+        }
+        return &cell.command;
+    }
+
+    void CommandQueue::pop() {
+        Cell& cell = m_cells[m_dequeuePos & (CAPACITY - 1)];
+        cell.sequence.store(m_dequeuePos + CAPACITY, std::memory_order_release);
+        ++m_dequeuePos;
+    }
+
+    bool CommandQueue::empty() const {
+        const Cell& cell = m_cells[m_dequeuePos & (CAPACITY - 1)];
+        return cell.sequence.load(std::memory_order_acquire) != m_dequeuePos + 1;
+    }
+
+    // PendingCommandTable implementation
+    PendingCommandTable::PendingCommandTable() {
+        for (size_t i = 0; i < CAPACITY; ++i) {
+            m_freeList[i] = static_cast<uint16_t>(CAPACITY - 1 - i);
+            m_generations[i] = 1;
+        }
+    }
+
+    PendingCommand* PendingCommandTable::acquire(bool expectResponse, std::chrono::milliseconds timeout,
+        bool withPromise) {
+        if (m_freeCount == 0) {
+            return nullptr;
+        }
+        if (m_fifoTail - m_fifoHead == FIFO_CAPACITY) {
+            compactFifo();
+        }
+
+        uint16_t index = m_freeList[--m_freeCount];
+        PendingCommand& slot = m_slots[index];
+        slot.command_id = static_cast<int>((m_generations[index] << INDEX_BITS) | index);
+        slot.status.store(PendingCommand::Pending, std::memory_order_relaxed);
+        slot.has_promise = withPromise;
+        if (withPromise) {
+            slot.promise.emplace();
+        }
+        slot.timestamp = std::chrono::steady_clock::now();
+        slot.expect_response = expectResponse;
+        slot.untagged_match = {};
+        slot.timeout = timeout;
+
+        m_fifo[m_fifoTail++ % FIFO_CAPACITY] = slot.command_id;
+
+        // query() waiters enforce their own deadline
+        if (withPromise) {
+            if (m_timeoutCount == TIMEOUT_CAPACITY) {
+                compactTimeouts();
+            }
+            m_timeouts[m_timeoutCount++] = TimeoutEntry{ slot.timestamp + timeout, slot.command_id };
+            std::push_heap(m_timeouts.begin(), m_timeouts.begin() + m_timeoutCount, std::greater<TimeoutEntry>());
+        }
+        return &slot;
+    }
+
+    void PendingCommandTable::release(PendingCommand& command) {
+        uint32_t index = static_cast<uint32_t>(command.command_id) & (CAPACITY - 1);
+        command.command_id = 0;
+        m_generations[index] = m_generations[index] == MAX_GENERATION ? 1 : m_generations[index] + 1;
+        m_freeList[m_freeCount++] = static_cast<uint16_t>(index);
+    }
+
+    bool PendingCommandTable::isLive(int id) const {
+        const PendingCommand& slot = m_slots[static_cast<uint32_t>(id) & (CAPACITY - 1)];
+        return id > 0 && slot.command_id == id &&
+            slot.status.load(std::memory_order_relaxed) == PendingCommand::Pending;
+    }
+
+    PendingCommand* PendingCommandTable::find(int id) {
+        return isLive(id) ? &m_slots[static_cast<uint32_t>(id) & (CAPACITY - 1)] : nullptr;
+    }
+
+    PendingCommand* PendingCommandTable::oldest() {
+        // Entries completed by id or timed out are skipped lazily
+        while (m_fifoHead != m_fifoTail) {
+            int id = m_fifo[m_fifoHead % FIFO_CAPACITY];
+            if (isLive(id)) {
+                return find(id);
+            }
+            ++m_fifoHead;
+        }
+        return nullptr;
+    }
+
+    PendingCommand* PendingCommandTable::popExpired(TimePoint now) {
+        while (m_timeoutCount > 0 && m_timeouts[0].deadline <= now) {
+            int id = m_timeouts[0].id;
+            std::pop_heap(m_timeouts.begin(), m_timeouts.begin() + m_timeoutCount, std::greater<TimeoutEntry>());
+            --m_timeoutCount;
+            if (PendingCommand* command = find(id)) {
+                return command;
+            }
+        }
+        return nullptr;
+    }
+
+    PendingCommandTable::TimePoint PendingCommandTable::nextDeadline() {
+        while (m_timeoutCount > 0 && !isLive(m_timeouts[0].id)) {
+            std::pop_heap(m_timeouts.begin(), m_timeouts.begin() + m_timeoutCount, std::greater<TimeoutEntry>());
+            --m_timeoutCount;
+        }
+        return m_timeoutCount > 0 ? m_timeouts[0].deadline : TimePoint::max();
+    }
+
+    void PendingCommandTable::compactTimeouts() {
+        auto end = std::remove_if(m_timeouts.begin(), m_timeouts.begin() + m_timeoutCount,
+            [this](const TimeoutEntry& entry) { return !isLive(entry.id); });
+        m_timeoutCount = static_cast<size_t>(end - m_timeouts.begin());
+        std::make_heap(m_timeouts.begin(), m_timeouts.begin() + m_timeoutCount, std::greater<TimeoutEntry>());
+    }
+
+    void PendingCommandTable::compactFifo() {
+        // At most CAPACITY entries are live, so this always frees space
+        size_t out = m_fifoHead;
+        for (size_t in = m_fifoHead; in != m_fifoTail; ++in) {
+            int id = m_fifo[in % FIFO_CAPACITY];
+            if (isLive(id)) {
+                m_fifo[out++ % FIFO_CAPACITY] = id;
+            }
+        }
+        m_fifoTail = out;
+    }
+
+    SerialPort::SerialPort()
+        : m_baudRate(115200)
+        , m_timeout(100)  // Reduced from 1000ms
+        , m_isOpen(false)
+#ifdef _WIN32
+        , m_handle(INVALID_HANDLE_VALUE)
+        , m_writeEvent(nullptr)
+#else
+        , m_fd(-1)
+#endif
+    {
+#ifdef _WIN32
+        memset(&m_dcb, 0, sizeof(m_dcb));
+        memset(&m_timeouts, 0, sizeof(m_timeouts));
+#endif
+    }
+
+    SerialPort::~SerialPort() {
+        close();
+        stopScheduler();  // Started by a schedule() that raced close()
+        if (m_rtMemoryLocked.load()) {
+            lockProcessMemory(false);  // Process-wide; only undo what this port did
+        }
+    }
+
+    bool SerialPort::open(const std::string& port, uint32_t baudRate) {
+        if (m_isOpen) {
+            close();
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_portName = port;
+        m_baudRate = baudRate;
+
+#ifdef _WIN32
+        std::string fullPortName = "\\\\.\\" + port;
+
+        m_handle = CreateFileA(
+            fullPortName.c_str(),
+            GENERIC_READ | GENERIC_WRITE,
+            0,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED,
+            nullptr
+        );
+
+        if (m_handle == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+
+        m_writeEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+        if (!configurePort() || !m_writeEvent || !m_listenerWake.create()) {
+            if (m_writeEvent) {
+                CloseHandle(m_writeEvent);
+                m_writeEvent = nullptr;
+            }
+            CloseHandle(m_handle);
+            m_handle = INVALID_HANDLE_VALUE;
+            return false;
+        }
+
+        m_isOpen = true;
+
+        // Start high-performance listener thread
+        m_stopListener = false;
+        m_linePos = 0;
+        m_lineOverflow = false;
+        m_encoder = &CommandEncoder::forProtocol(WireProtocol::ASCII);  // Until negotiated
+        m_listenerThread = std::thread(&SerialPort::listenerLoop, this);
+
+        if (m_writerEnabled) {
+            startWriter();
+        }
+
+        return true;
+#else
+        std::string devicePath = port.compare(0, 1, "/") == 0 ? port : "/dev/" + port;
+
+        m_fd = ::open(devicePath.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+        if (m_fd < 0) {
+            return false;
+        }
+
+        if (!configurePort() || !m_listenerWake.create()) {
+            ::close(m_fd);
+            m_fd = -1;
+            return false;
+        }
+
+        if (m_ioBackend.load() == IoBackend::IO_URING) {
+            startIoUring();  // Stays on poll() if the ring cannot be set up
+        }
+
+        m_isOpen = true;
+
+        // Start high-performance listener thread
+        m_stopListener = false;
+        m_linePos = 0;
+        m_lineOverflow = false;
+        m_encoder = &CommandEncoder::forProtocol(WireProtocol::ASCII);  // Until negotiated
+        m_listenerThread = std::thread(&SerialPort::listenerLoop, this);
+
+        if (m_writerEnabled) {
+            startWriter();
+        }
+
+        return true;
+#endif
+    }
+
+    void SerialPort::close() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (!m_isOpen) {
+            return;
+        }
+
+        // Drop scheduled steps, then flush queued commands before the handle goes away
+        stopScheduler();
+        stopWriter();
+
+        // Stop listener thread; the wake handle interrupts its blocking wait
+        m_stopListener = true;
+        m_listenerWake.signal();
+        if (m_listenerThread.joinable()) {
+            m_listenerThread.join();
+        }
+        m_listenerWake.destroy();
+
+        // Writes still queued on the ring go out before the fd closes
+        std::unique_ptr<IoUring> ring;
+        {
+            std::lock_guard<std::mutex> writeLock(m_writeMutex);
+            ring = std::move(m_uring);
+        }
+        IoUring::retire(std::move(ring));
+
+        // Cancel all pending commands
+        {
+            std::lock_guard<std::mutex> cmdLock(m_commandMutex);
+            m_pendingCommands.forEachActive([this](PendingCommand& cmd) {
+                if (cmd.status.load(std::memory_order_relaxed) == PendingCommand::Pending) {
+                    failCommand(cmd, "Connection closed");
+                }
+                });
+        }
+
+#ifdef _WIN32
+        if (m_writeEvent) {
+            CloseHandle(m_writeEvent);
+            m_writeEvent = nullptr;
+        }
+        if (m_handle != INVALID_HANDLE_VALUE) {
+            CloseHandle(m_handle);
+            m_handle = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (m_fd >= 0) {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+#endif
+
+        m_isOpen = false;
+    }
+
+    bool SerialPort::isOpen() const {
+        return m_isOpen;
+    }
+
+    std::future<std::string> SerialPort::sendTrackedCommand(const std::string& command,
+        bool expectResponse,
+        std::chrono::milliseconds timeout) {
+        if (!m_isOpen) {
+            std::promise<std::string> promise;
+            promise.set_exception(std::make_exception_ptr(
+                std::runtime_error("Port not open")));
+            return promise.get_future();
+        }
+
+        // Registration and submit share the lock so the in-flight FIFO
+        // matches the order commands reach the wire
+        std::lock_guard<std::mutex> lock(m_commandMutex);
+        PendingCommand* pending = m_pendingCommands.acquire(expectResponse, timeout, true);
+        if (!pending) {
+            std::promise<std::string> promise;
+            promise.set_exception(std::make_exception_ptr(
+                std::runtime_error("Too many commands in flight")));
+            return promise.get_future();
+        }
+        auto future = pending->promise->get_future();
+
+        // Wake the listener if this deadline precedes the one it sleeps towards
+        auto deadline = pending->timestamp + timeout;
+        if (deadline < m_listenerDeadline) {
+            m_listenerDeadline = deadline;
+            m_listenerWake.signal();
+        }
+
+        // Send command with ID tracking
+        std::string trackedCommand = expectResponse ?
+            command + "#" + std::to_string(pending->command_id) + "\r\n" :
+            command + "\r\n";
+
+        if (!submit(trackedCommand.data(), trackedCommand.size(), CommandPriority::QUERY)) {
+            failCommand(*pending, "Write failed");
+        }
+
+        return future;
+    }
+
+    bool SerialPort::query(const std::string& command, std::string& response,
+        std::chrono::milliseconds timeout, std::string_view untaggedMatch) {
+        if (!m_isOpen) {
+            return false;
+        }
+
+        // Only the slot table needs the lock: without the writer thread
+        // submit() blocks on the port, and holding m_commandMutex through it
+        // would stall the listener's reply processing. The id is tagged, so
+        // a reply may complete the slot even before submit() returns
+        PendingCommand* pending;
+        int commandId;
+        {
+            std::lock_guard<std::mutex> lock(m_commandMutex);
+            pending = m_pendingCommands.acquire(true, timeout, false);
+            if (!pending) {
+                return false;
+            }
+            pending->untagged_match = untaggedMatch;  // Valid until query() returns
+            commandId = pending->command_id;
+        }
+
+        std::string trackedCommand = command + "#" + std::to_string(commandId) + "\r\n";
+        if (!submit(trackedCommand.data(), trackedCommand.size(), CommandPriority::QUERY)) {
+            std::lock_guard<std::mutex> lock(m_commandMutex);
+            m_pendingCommands.release(*pending);
+            return false;
+        }
+
+        // Device round trips are sub-millisecond: optionally spin before
+        // paying for a sleep/wakeup pair
+        auto deadline = pending->timestamp + timeout;
+        int64_t spinNs = m_querySpinNs.load(std::memory_order_relaxed);
+        if (spinNs > 0) {
+            auto spinUntil = std::min(deadline, std::chrono::steady_clock::now() + std::chrono::nanoseconds(spinNs));
+            while (pending->status.load(std::memory_order_acquire) == PendingCommand::Pending &&
+                std::chrono::steady_clock::now() < spinUntil) {
+                std::this_thread::yield();
+            }
+        }
+        {
+            std::unique_lock<std::mutex> lock(pending->mutex);
+            pending->done.wait_until(lock, deadline, [pending] {
+                return pending->status.load(std::memory_order_acquire) != PendingCommand::Pending;
+                });
+        }
+
+        // Releasing bumps the slot generation, so a reply that arrives after a
+        // timeout finds no live command
+        std::lock_guard<std::mutex> lock(m_commandMutex);
+        bool ok = pending->status.load(std::memory_order_acquire) == PendingCommand::Ready;
+        if (ok) {
+            response.swap(pending->result);
+        }
+        m_pendingCommands.release(*pending);
+        return ok;
+    }
+
+    void SerialPort::setQuerySpinTime(std::chrono::microseconds spin) {
+        m_querySpinNs = std::max<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(spin).count(), 0);
+    }
+
+    std::chrono::microseconds SerialPort::getQuerySpinTime() const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::nanoseconds(m_querySpinNs.load()));
+    }
+
+    bool SerialPort::sendCommand(std::string_view command) {
+        if (!m_isOpen) {
+            return false;
+        }
+
+        char line[OutboundCommand::INLINE_CAPACITY];
+        if (command.size() + 2 <= sizeof(line)) {
+            memcpy(line, command.data(), command.size());
+            memcpy(line + command.size(), "\r\n", 2);
+            return submit(line, command.size() + 2, classifyCommand(command));
+        }
+
+        std::string fullCommand;
+        fullCommand.reserve(command.size() + 2);
+        fullCommand.append(command).append("\r\n");
+        return submit(fullCommand.data(), fullCommand.size(), classifyCommand(command));
+    }
+
+    bool SerialPort::sendMove(int32_t dx, int32_t dy) {
+        if (!m_isOpen) {
+            return false;
+        }
+
+        if (m_writerRunning.load(std::memory_order_acquire) &&
+            enqueue(CommandPriority::MOTION, [dx, dy](OutboundCommand& command) {
+                command.assignDelta(OutboundCommand::Kind::Move, dx, dy);
+                })) {
+            return true;
+        }
+
+        std::vector<char>& encoded = encodeScratch();
+        m_encoder.load(std::memory_order_acquire)->appendMove(encoded, dx, dy);
+        return writeAll(encoded.data(), encoded.size());
+    }
+
+    bool SerialPort::sendWheel(int32_t delta) {
+        if (!m_isOpen) {
+            return false;
+        }
+
+        if (m_writerRunning.load(std::memory_order_acquire) &&
+            enqueue(CommandPriority::MOTION, [delta](OutboundCommand& command) {
+                command.assignDelta(OutboundCommand::Kind::Wheel, delta, 0);
+                })) {
+            return true;
+        }
+
+        std::vector<char>& encoded = encodeScratch();
+        m_encoder.load(std::memory_order_acquire)->appendWheel(encoded, delta);
+        return writeAll(encoded.data(), encoded.size());
+    }
+
+    bool SerialPort::sendButton(MouseButton button, bool pressed) {
+        if (!m_isOpen) {
+            return false;
+        }
+
+        std::vector<char>& encoded = encodeScratch();
+        if (!m_encoder.load(std::memory_order_acquire)->appendButton(encoded, button, pressed)) {
+            return false;
+        }
+        return submit(encoded.data(), encoded.size(), CommandPriority::CONTROL);
+    }
+
+    bool SerialPort::sendEncoded(const char* data, size_t length, CommandPriority priority) {
+        if (!m_isOpen) {
+            return false;
+        }
+
+        return length == 0 || submit(data, length, priority);
+    }
+
+    bool SerialPort::sendSmoothMove(int32_t dx, int32_t dy, uint32_t segments) {
+        if (!m_isOpen) {
+            return false;
+        }
+
+        char line[CommandEncoder::MAX_TEXT_COMMAND];
+        return submit(line, CommandEncoder::formatMove(line, dx, dy, segments), CommandPriority::MOTION);
+    }
+
+    bool SerialPort::sendBezierMove(int32_t dx, int32_t dy, uint32_t segments, int32_t cx, int32_t cy) {
+        if (!m_isOpen) {
+            return false;
+        }
+
+        char line[CommandEncoder::MAX_TEXT_COMMAND];
+        return submit(line, CommandEncoder::formatMove(line, dx, dy, segments, cx, cy), CommandPriority::MOTION);
+    }
+
+    void SerialPort::setWireProtocol(WireProtocol protocol) {
+        m_encoder.store(&CommandEncoder::forProtocol(protocol), std::memory_order_release);
+    }
+
+    WireProtocol SerialPort::getWireProtocol() const {
+        return m_encoder.load(std::memory_order_acquire)->protocol();
+    }
+
+    bool SerialPort::submit(const char* data, size_t length, CommandPriority priority) {
+        if (m_writerRunning.load(std::memory_order_acquire) &&
+            enqueue(priority, [data, length](OutboundCommand& command) {
+                command.assign(data, length);
+                })) {
+            return true;
+        }
+        return writeAll(data, length);
+    }
+
+    bool SerialPort::writeAll(const char* data, size_t length) {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        return writeAllLocked(data, length);
+    }
+
+    // Caller holds m_writeMutex
+    bool SerialPort::writeAllLocked(const char* data, size_t length) {
+#ifdef _WIN32
+        OVERLAPPED overlapped{};
+        overlapped.hEvent = m_writeEvent;
+
+        DWORD bytesWritten = 0;
+        bool success = WriteFile(m_handle, data,
+            static_cast<DWORD>(length),
+            &bytesWritten, &overlapped) != 0;
+
+        if (!success && GetLastError() == ERROR_IO_PENDING) {
+            success = GetOverlappedResult(m_handle, &overlapped, &bytesWritten, TRUE) != 0;
+        }
+
+        if (success && bytesWritten == length) {
+            FlushFileBuffers(m_handle);
+            m_statBytesWritten.fetch_add(length, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+#else
+        if (m_uring) {
+            if (!m_uring->write(data, length, std::chrono::milliseconds(m_timeout))) {
+                return false;
+            }
+            m_statBytesWritten.fetch_add(length, std::memory_order_relaxed);
+            return true;
+        }
+
+        // Non-blocking fd: wait for POLLOUT whenever the tty buffer is full
+        size_t written = 0;
+        while (written < length) {
+            ssize_t n = ::write(m_fd, data + written, length - written);
+            if (n > 0) {
+                written += static_cast<size_t>(n);
+                continue;
+            }
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                pollfd pfd{ m_fd, POLLOUT, 0 };
+                if (::poll(&pfd, 1, static_cast<int>(m_timeout)) <= 0) {
+                    return false;
+                }
+                continue;
+            }
+            return false;
+        }
+        m_statBytesWritten.fetch_add(length, std::memory_order_relaxed);
+        return true;
+#endif
+    }
+
+    // Writer thread: producers push into the lock-free ring, the writer drains
+    // every ready command into one staging buffer and issues a single write
+    // Returns false if the writer is stopping or stopped; the caller then
+    // writes inline. While a producer is inside, stopWriter() holds off its
+    // final flush and the destruction of the wake handle
+    template<typename Fill>
+    bool SerialPort::enqueue(CommandPriority priority, Fill&& fill) {
+        struct InFlight {
+            std::atomic<uint32_t>& count;
+            explicit InFlight(std::atomic<uint32_t>& counter) : count(counter) { count.fetch_add(1, std::memory_order_seq_cst); }
+            ~InFlight() { count.fetch_sub(1, std::memory_order_release); }
+        } inFlight(m_producersInFlight);
+        if (!m_writerRunning.load(std::memory_order_seq_cst)) {
+            return false;
+        }
+
+        CommandQueue& queue = m_outbound[m_priorityClasses.load(std::memory_order_relaxed) ?
+            static_cast<size_t>(priority) : 0];
+        auto fillClassified = [&fill, priority](OutboundCommand& command) {
+            command.priority = priority;
+            fill(command);
+        };
+        while (!queue.tryPush(fillClassified)) {
+            m_statQueueFull.fetch_add(1, std::memory_order_relaxed);
+            if (!m_writerRunning.load(std::memory_order_acquire)) {
+                return false;
+            }
+            m_writerWake.signal();
+            std::this_thread::yield();
+        }
+        m_statQueued.fetch_add(1, std::memory_order_relaxed);
+
+        // Only pay for a wakeup when the writer has gone to sleep
+        if (m_writerIdle.exchange(false, std::memory_order_acq_rel)) {
+            m_writerWake.signal();
+        }
+        return true;
+    }
+
+    void SerialPort::setWriterThreadEnabled(bool enable) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        setWriterThreadEnabledLocked(enable);
+    }
+
+    // Caller holds m_mutex, so open()/close() cannot start or join the
+    // writer at the same time
+    void SerialPort::setWriterThreadEnabledLocked(bool enable) {
+        m_writerEnabled = enable;
+        if (!m_isOpen) {
+            return;
+        }
+        if (enable) {
+            startWriter();
+        }
+        else {
+            stopWriter();
+        }
+    }
+
+    bool SerialPort::isWriterThreadEnabled() const {
+        return m_writerEnabled.load();
+    }
+
+    void SerialPort::setCoalescingEnabled(bool enable) {
+        m_coalescing = enable;
+    }
+
+    bool SerialPort::isCoalescingEnabled() const {
+        return m_coalescing.load();
+    }
+
+    void SerialPort::setPacingInterval(std::chrono::microseconds interval) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(interval).count();
+        m_pacingIntervalNs = std::max<int64_t>(ns, 0);
+        if (ns > 0 && !m_writerEnabled) {
+            setWriterThreadEnabledLocked(true);
+        }
+        if (m_writerRunning.load(std::memory_order_acquire)) {
+            m_writerWake.signal();
+        }
+    }
+
+    std::chrono::microseconds SerialPort::getPacingInterval() const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::nanoseconds(m_pacingIntervalNs.load()));
+    }
+
+    void SerialPort::setPriorityClassesEnabled(bool enable) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // Queued commands sit in the old queue layout, where new ones would
+        // overtake them; the writer drains them before the switch
+        bool restart = m_priorityClasses.load() != enable && m_writerRunning.load(std::memory_order_acquire);
+        if (restart) {
+            stopWriter();
+        }
+        m_priorityClasses = enable;
+        if (restart) {
+            startWriter();
+        }
+        if (enable && !m_writerEnabled) {
+            setWriterThreadEnabledLocked(true);
+        }
+    }
+
+    bool SerialPort::isPriorityClassesEnabled() const {
+        return m_priorityClasses.load();
+    }
+
+    void SerialPort::setStarvationLimit(std::chrono::microseconds limit) {
+        m_starvationLimitNs = std::max<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(limit).count(), 0);
+    }
+
+    std::chrono::microseconds SerialPort::getStarvationLimit() const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::nanoseconds(m_starvationLimitNs.load()));
+    }
+
+    bool SerialPort::outboundEmpty() const {
+        for (const CommandQueue& queue : m_outbound) {
+            if (!queue.empty()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    WriterStats SerialPort::getWriterStats() const {
+        WriterStats stats;
+        stats.commandsQueued = m_statQueued.load(std::memory_order_relaxed);
+        stats.commandsWritten = m_statWritten.load(std::memory_order_relaxed);
+        stats.writeSyscalls = m_statSyscalls.load(std::memory_order_relaxed);
+        stats.writeErrors = m_statWriteErrors.load(std::memory_order_relaxed);
+        stats.queueFullWaits = m_statQueueFull.load(std::memory_order_relaxed);
+        stats.totalLatencyNs = m_statLatencyNs.load(std::memory_order_relaxed);
+        stats.maxLatencyNs = m_statMaxLatencyNs.load(std::memory_order_relaxed);
+        stats.movesMerged = m_statMovesMerged.load(std::memory_order_relaxed);
+        stats.wheelsMerged = m_statWheelsMerged.load(std::memory_order_relaxed);
+        stats.pacedTicks = m_statPacedTicks.load(std::memory_order_relaxed);
+        stats.pacingJitterNs = m_statPacingJitterNs.load(std::memory_order_relaxed);
+        stats.maxPacingJitterNs = m_statMaxPacingJitterNs.load(std::memory_order_relaxed);
+        stats.bytesWritten = m_statBytesWritten.load(std::memory_order_relaxed);
+        for (size_t index = 0; index < COMMAND_PRIORITY_COUNT; ++index) {
+            stats.classes[index].commands = m_statClassCommands[index].load(std::memory_order_relaxed);
+            stats.classes[index].totalDelayNs = m_statClassDelayNs[index].load(std::memory_order_relaxed);
+            stats.classes[index].maxDelayNs = m_statClassMaxDelayNs[index].load(std::memory_order_relaxed);
+            stats.classes[index].promotions = m_statClassPromotions[index].load(std::memory_order_relaxed);
+        }
+        return stats;
+    }
+
+    void SerialPort::startWriter() {
+        if (m_writerRunning || m_writerThread.joinable()) {
+            return;
+        }
+        if (!m_writerWake.create() || !m_pacingTimer.create()) {
+            return;
+        }
+        m_stopWriter = false;
+        m_writerIdle = false;
+        m_writeStaging.reserve(BUFFER_SIZE);
+        m_writerRunning.store(true, std::memory_order_release);
+        m_writerThread = std::thread(&SerialPort::writerLoop, this);
+    }
+
+    void SerialPort::stopWriter() {
+        if (!m_writerThread.joinable()) {
+            return;
+        }
+        // The writer drains the ring before exiting; producers keep queueing
+        // until it is gone so nothing overtakes commands already in flight
+        m_stopWriter = true;
+        m_writerWake.signal();
+        m_writerThread.join();
+
+        // The write lock is held until the residue is out, so a producer that
+        // falls back to writing inline cannot overtake its own queued commands.
+        // Producers that saw the writer running finish their push first
+        std::lock_guard<std::mutex> writeLock(m_writeMutex);
+        m_writerRunning.store(false, std::memory_order_seq_cst);
+        while (m_producersInFlight.load(std::memory_order_acquire) != 0) {
+            std::this_thread::yield();
+        }
+
+        // Commands that raced the shutdown are written inline, in class order
+        std::vector<char> residual;
+        for (CommandQueue& queue : m_outbound) {
+            while (OutboundCommand* command = queue.front()) {
+                appendCommand(residual, *command, *m_encoder.load(std::memory_order_acquire));
+                queue.pop();
+            }
+        }
+        if (!residual.empty()) {
+            writeAllLocked(residual.data(), residual.size());
+        }
+        m_writerWake.destroy();
+        m_pacingTimer.destroy();
+    }
+
+    void SerialPort::writerLoop() {
+        using Clock = std::chrono::steady_clock;
+        constexpr uint64_t NO_TICK = std::numeric_limits<uint64_t>::max();
+
+        // Pacing grid: tick k fires at pacingEpoch + k * interval
+        int64_t pacingNs = 0;
+        Clock::time_point pacingEpoch;
+        uint64_t lastReleasedTick = NO_TICK;
+
+        uint32_t realtimeSeen = 0;
+        while (true) {
+            if (m_realtimeGeneration.load(std::memory_order_relaxed) != realtimeSeen) {
+                realtimeSeen = applyRealtime(ThreadRole::Writer);
+            }
+
+            int64_t intervalNs = m_pacingIntervalNs.load(std::memory_order_relaxed);
+            if (intervalNs != pacingNs) {
+                pacingNs = intervalNs;
+                pacingEpoch = Clock::now();
+                lastReleasedTick = NO_TICK;
+            }
+
+            // Unpaced: every delta run goes out. Paced: one run per grid tick,
+            // none between ticks (raw commands at the head still go out)
+            uint64_t tick = 0;
+            size_t runsAllowed = std::numeric_limits<size_t>::max();
+            bool paced = pacingNs > 0 && !m_stopWriter;  // Shutdown flushes the backlog at once
+            if (paced) {
+                tick = static_cast<uint64_t>((Clock::now() - pacingEpoch).count() /
+                    std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(pacingNs)).count());
+                runsAllowed = (lastReleasedTick == NO_TICK || tick > lastReleasedTick) ? 1 : 0;
+            }
+
+            bool deltaReleased = false;
+            bool wrote = drainOutbound(runsAllowed, deltaReleased);
+
+            if (paced && deltaReleased) {
+                auto tickTime = pacingEpoch + std::chrono::nanoseconds(static_cast<int64_t>(tick) * pacingNs);
+                uint64_t lateness = toNanoseconds(Clock::now()) - toNanoseconds(tickTime);
+                lastReleasedTick = tick;
+                m_statPacedTicks.fetch_add(1, std::memory_order_relaxed);
+                m_statPacingJitterNs.fetch_add(lateness, std::memory_order_relaxed);
+                if (lateness > m_statMaxPacingJitterNs.load(std::memory_order_relaxed)) {
+                    m_statMaxPacingJitterNs.store(lateness, std::memory_order_relaxed);
+                }
+            }
+
+            if (wrote) {
+                continue;
+            }
+
+            // Anything still queued now is a delta waiting for the next tick
+            bool deltaPending = !outboundEmpty();
+            if (m_stopWriter) {
+                if (!deltaPending) {
+                    break;
+                }
+                continue;
+            }
+
+            auto deadline = Clock::time_point::max();
+            if (deltaPending) {
+                uint64_t nextTick = (lastReleasedTick == NO_TICK) ? tick : std::max(tick, lastReleasedTick + 1);
+                deadline = pacingEpoch + std::chrono::nanoseconds(static_cast<int64_t>(nextTick) * pacingNs);
+            }
+            else {
+                // Announce that we are about to sleep, then re-check so a producer
+                // that pushed before seeing the flag is not missed
+                m_writerIdle.store(true, std::memory_order_seq_cst);
+                if (!outboundEmpty()) {
+                    m_writerIdle.store(false, std::memory_order_relaxed);
+                    continue;
+                }
+            }
+
+            m_pacingTimer.wait(m_writerWake, deadline);
+            m_writerIdle.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    // Timer scheduler: one thread sleeps on the earliest deadline (absolute
+    // timerfd / high-resolution waitable timer) and submits due commands, so
+    // callers never sleep and delays do not accumulate oversleep
+    ScheduledAction SerialPort::schedule(const std::vector<ScheduleStep>& steps) {
+        auto state = std::make_shared<ScheduledAction::State>();
+        if (!m_isOpen || steps.empty()) {
+            state->failed = 1;
+            return ScheduledAction(state);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_scheduleMutex);
+            if (!startSchedulerLocked()) {
+                state->failed = 1;
+                return ScheduledAction(state);
+            }
+
+            state->remaining.store(static_cast<uint32_t>(steps.size()), std::memory_order_relaxed);
+            bool buttons = false;
+            for (const auto& [deadline, command] : steps) {
+                uint8_t presses = 0;
+                uint8_t releases = 0;
+                buttonTransition(command, presses, releases);
+                buttons = buttons || presses != 0;
+                m_schedule.push(ScheduledCommand{ deadline, m_scheduleSequence++, command + "\r\n",
+                    nullptr, 0, 0, classifyCommand(command), state, presses, releases });
+            }
+            if (buttons) {
+                armReleaseHeld(*state);
+            }
+        }
+        m_schedulerWake.signal();
+        return ScheduledAction(state);
+    }
+
+    ScheduledAction SerialPort::scheduleEncoded(std::chrono::steady_clock::time_point start,
+        std::shared_ptr<const std::vector<char>> bytes, const EncodedSlot* slots, size_t count, uint8_t held) {
+        auto state = std::make_shared<ScheduledAction::State>();
+        if (!m_isOpen || !bytes || count == 0) {
+            state->failed = 1;
+            return ScheduledAction(state);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_scheduleMutex);
+            if (!startSchedulerLocked()) {
+                state->failed = 1;
+                return ScheduledAction(state);
+            }
+
+            state->remaining.store(static_cast<uint32_t>(count), std::memory_order_relaxed);
+            state->held = held;
+            bool buttons = held != 0;
+            for (const EncodedSlot* slot = slots; slot != slots + count; ++slot) {
+                buttons = buttons || slot->presses != 0;
+                m_schedule.push(ScheduledCommand{ start + slot->offset, m_scheduleSequence++, std::string(),
+                    bytes, slot->begin, slot->length, slot->priority, state, slot->presses, slot->releases });
+            }
+            if (buttons) {
+                armReleaseHeld(*state);
+            }
+        }
+        m_schedulerWake.signal();
+        return ScheduledAction(state);
+    }
+
+    // cancel() (and close()) release what the action still holds. The hook
+    // is cleared before the port could go away: when the last step fired
+    // or, in stopScheduler(), for actions still queued
+    void SerialPort::armReleaseHeld(ScheduledAction::State& state) {
+        state.releaseHeld = [this](uint8_t held) {
+            for (size_t index = 0; index < BUTTON_COUNT; ++index) {
+                if (held & (1u << index)) {
+                    sendButton(static_cast<MouseButton>(index), false);
+                }
+            }
+        };
+    }
+
+    bool SerialPort::startSchedulerLocked() {
+        if (m_schedulerThread.joinable()) {
+            return true;
+        }
+        if (!m_schedulerWake.create() || !m_schedulerTimer.create()) {
+            m_schedulerWake.destroy();
+            return false;
+        }
+        m_stopScheduler = false;
+        m_schedulerThread = std::thread(&SerialPort::schedulerLoop, this);
+        return true;
+    }
+
+    ScheduleStats SerialPort::getScheduleStats() const {
+        ScheduleStats stats;
+        stats.fired = m_statScheduledFired.load(std::memory_order_relaxed);
+        stats.cancelled = m_statScheduledCancelled.load(std::memory_order_relaxed);
+        stats.totalLatenessNs = m_statScheduleLatenessNs.load(std::memory_order_relaxed);
+        stats.maxLatenessNs = m_statMaxScheduleLatenessNs.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void SerialPort::stopScheduler() {
+        if (!m_schedulerThread.joinable()) {
+            return;
+        }
+        m_stopScheduler = true;
+        m_schedulerWake.signal();
+        m_schedulerThread.join();
+
+        // Steps that never fired are cancelled so waiters return, and buttons
+        // their actions pressed are released while the port is still open
+        std::lock_guard<std::mutex> lock(m_scheduleMutex);
+        while (!m_schedule.empty()) {
+            auto state = m_schedule.top().state;
+            m_schedule.pop();
+            m_statScheduledCancelled.fetch_add(1, std::memory_order_relaxed);
+            std::lock_guard<std::mutex> stateLock(state->mutex);
+            if (!state->cancelled.exchange(true)) {
+                if (state->held != 0 && state->releaseHeld) {
+                    state->releaseHeld(state->held);
+                }
+                state->held = 0;
+                state->done.notify_all();
+            }
+            state->releaseHeld = nullptr;
+        }
+        m_schedulerWake.destroy();
+        m_schedulerTimer.destroy();
+    }
+
+    void SerialPort::schedulerLoop() {
+        using Clock = std::chrono::steady_clock;
+        std::vector<ScheduledCommand> due;
+
+        uint32_t realtimeSeen = 0;
+        while (!m_stopScheduler) {
+            if (m_realtimeGeneration.load(std::memory_order_relaxed) != realtimeSeen) {
+                realtimeSeen = applyRealtime(ThreadRole::Scheduler);
+            }
+
+            auto deadline = Clock::time_point::max();
+            {
+                std::lock_guard<std::mutex> lock(m_scheduleMutex);
+                auto now = Clock::now();
+                while (!m_schedule.empty() && m_schedule.top().deadline <= now) {
+                    due.push_back(m_schedule.top());
+                    m_schedule.pop();
+                }
+                if (due.empty() && !m_schedule.empty()) {
+                    deadline = m_schedule.top().deadline;
+                }
+            }
+
+            if (due.empty()) {
+                m_schedulerTimer.wait(m_schedulerWake, deadline);
+                continue;
+            }
+
+            for (auto& entry : due) {
+                auto& state = *entry.state;
+                bool ok;
+                if (entry.presses == 0 && entry.releases == 0) {
+                    if (state.cancelled.load(std::memory_order_acquire)) {
+                        m_statScheduledCancelled.fetch_add(1, std::memory_order_relaxed);
+                        continue;
+                    }
+                    ok = submit(entry.data(), entry.size(), entry.priority);
+                }
+                else {
+                    // Written and recorded as held under the state lock, so
+                    // cancel() either drops the press or releases it
+                    std::lock_guard<std::mutex> stateLock(state.mutex);
+                    if (state.cancelled.load(std::memory_order_acquire)) {
+                        m_statScheduledCancelled.fetch_add(1, std::memory_order_relaxed);
+                        continue;
+                    }
+                    ok = submit(entry.data(), entry.size(), entry.priority);
+                    state.held = static_cast<uint8_t>((state.held & ~entry.releases) | entry.presses);
+                }
+                uint64_t lateness = toNanoseconds(Clock::now()) - toNanoseconds(entry.deadline);
+                m_statScheduledFired.fetch_add(1, std::memory_order_relaxed);
+                m_statScheduleLatenessNs.fetch_add(lateness, std::memory_order_relaxed);
+                if (lateness > m_statMaxScheduleLatenessNs.load(std::memory_order_relaxed)) {
+                    m_statMaxScheduleLatenessNs.store(lateness, std::memory_order_relaxed);
+                }
+
+                if (!ok) {
+                    state.failed.fetch_add(1, std::memory_order_relaxed);
+                }
+                if (state.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    std::lock_guard<std::mutex> stateLock(state.mutex);
+                    state.releaseHeld = nullptr;
+                    state.done.notify_all();
+                }
+            }
+            due.clear();
+        }
+    }
+
+    // Copy ready commands into the staging buffer and write them in one call.
+    // Between two raw commands (buttons, locks, queries) every move collapses
+    // into one km.move and every wheel step into one km.wheel, emitted in order
+    // of first appearance; raw commands end the run, so nothing is reordered
+    // across them. Stops at a delta once deltaRunsAllowed runs have started.
+    // Queues are visited in class order, starved classes first; runs never
+    // span queues
+    bool SerialPort::drainOutbound(size_t deltaRunsAllowed, bool& deltaReleased) {
+        using Clock = std::chrono::steady_clock;
+        m_writeStaging.clear();
+        const CommandEncoder& encoder = *m_encoder.load(std::memory_order_acquire);
+        uint64_t batched = 0;
+        uint64_t enqueuedNsSum = 0;
+        auto oldest = Clock::time_point::max();
+
+        struct ClassBatch {
+            uint64_t commands = 0;
+            uint64_t enqueuedNsSum = 0;
+            Clock::time_point oldest = Clock::time_point::max();
+        } classBatches[COMMAND_PRIORITY_COUNT];
+
+        // Starvation guard: a queue that got nothing in the previous drain and
+        // whose head waited past the limit moves ahead of the classes above it.
+        // A backlogged class that is being served is not starved, nor is a
+        // delta held for the next pacing tick
+        size_t order[COMMAND_PRIORITY_COUNT];
+        size_t ordered = 0;
+        auto starvedBefore = Clock::now() - std::chrono::nanoseconds(m_starvationLimitNs.load(std::memory_order_relaxed));
+        bool higherPending = !m_outbound[0].empty();
+        for (size_t index = 1; index < COMMAND_PRIORITY_COUNT; ++index) {
+            const OutboundCommand* head = m_outbound[index].front();
+            if (!head) {
+                continue;
+            }
+            bool served = (m_classesServed >> index) & 1;
+            bool held = deltaRunsAllowed == 0 && head->kind != OutboundCommand::Kind::Raw;
+            if (higherPending && !served && !held && head->enqueued < starvedBefore) {
+                order[ordered++] = index;
+                m_statClassPromotions[index].fetch_add(1, std::memory_order_relaxed);
+            }
+            higherPending = true;
+        }
+        size_t promoted = ordered;
+        for (size_t index = 0; index < COMMAND_PRIORITY_COUNT; ++index) {
+            if (std::find(order, order + promoted, index) == order + promoted) {
+                order[ordered++] = index;
+            }
+        }
+
+        struct DeltaRun {
+            bool active = false;
+            int64_t x = 0;
+            int64_t y = 0;
+        } moveRun, wheelRun;
+        OutboundCommand::Kind firstInRun = OutboundCommand::Kind::Raw;
+        bool runOpen = false;
+        size_t runsStarted = 0;
+        bool paced = deltaRunsAllowed != std::numeric_limits<size_t>::max();
+        bool coalesce = paced || m_coalescing.load(std::memory_order_relaxed);
+        uint64_t movesMerged = 0;
+        uint64_t wheelsMerged = 0;
+
+        auto flushRun = [&]() {
+            auto emit = [&](OutboundCommand::Kind kind, DeltaRun& run) {
+                if (run.active) {
+                    if (kind == OutboundCommand::Kind::Move) {
+                        encoder.appendMove(m_writeStaging, saturate(run.x), saturate(run.y));
+                    }
+                    else {
+                        encoder.appendWheel(m_writeStaging, saturate(run.x));
+                    }
+                    run = DeltaRun{};
+                }
+            };
+            if (firstInRun == OutboundCommand::Kind::Wheel) {
+                emit(OutboundCommand::Kind::Wheel, wheelRun);
+            }
+            emit(OutboundCommand::Kind::Move, moveRun);
+            emit(OutboundCommand::Kind::Wheel, wheelRun);
+            firstInRun = OutboundCommand::Kind::Raw;
+            runOpen = false;
+        };
+
+        bool full = false;
+        for (size_t index : order) {
+            CommandQueue& queue = m_outbound[index];
+            while (OutboundCommand* command = queue.front()) {
+                if (batched > 0 && m_writeStaging.size() + command->length > BUFFER_SIZE) {
+                    full = true;
+                    break;
+                }
+
+                if (command->kind == OutboundCommand::Kind::Raw) {
+                    flushRun();
+                    m_writeStaging.insert(m_writeStaging.end(), command->data(), command->data() + command->length);
+                }
+                else {
+                    if (!runOpen) {
+                        if (runsStarted == deltaRunsAllowed) {
+                            break;
+                        }
+                        ++runsStarted;
+                        runOpen = true;
+                    }
+
+                    if (!coalesce) {
+                        appendCommand(m_writeStaging, *command, encoder);
+                    }
+                    else {
+                        bool isMove = command->kind == OutboundCommand::Kind::Move;
+                        DeltaRun& run = isMove ? moveRun : wheelRun;
+                        if (run.active) {
+                            ++(isMove ? movesMerged : wheelsMerged);
+                        }
+                        if (firstInRun == OutboundCommand::Kind::Raw) {
+                            firstInRun = command->kind;
+                        }
+                        run.active = true;
+                        run.x += command->x;
+                        run.y += command->y;
+                    }
+                }
+
+                ClassBatch& classBatch = classBatches[static_cast<size_t>(command->priority)];
+                ++classBatch.commands;
+                classBatch.enqueuedNsSum += toNanoseconds(command->enqueued);
+                classBatch.oldest = std::min(classBatch.oldest, command->enqueued);
+                oldest = std::min(oldest, command->enqueued);
+                enqueuedNsSum += toNanoseconds(command->enqueued);
+                queue.pop();
+                ++batched;
+            }
+            flushRun();
+            if (full) {
+                break;
+            }
+        }
+        deltaReleased = runsStarted > 0;
+
+        m_classesServed = 0;
+        for (size_t index = 0; index < COMMAND_PRIORITY_COUNT; ++index) {
+            if (classBatches[index].commands) {
+                m_classesServed |= 1u << index;
+            }
+        }
+
+        if (movesMerged || wheelsMerged) {
+            m_statMovesMerged.fetch_add(movesMerged, std::memory_order_relaxed);
+            m_statWheelsMerged.fetch_add(wheelsMerged, std::memory_order_relaxed);
+        }
+
+        if (batched == 0) {
+            return false;
+        }
+
+        bool ok = writeAll(m_writeStaging.data(), m_writeStaging.size());
+        auto wire = Clock::now();
+        uint64_t wireNs = toNanoseconds(wire);
+
+        m_statSyscalls.fetch_add(1, std::memory_order_relaxed);
+        m_statWritten.fetch_add(batched, std::memory_order_relaxed);
+        m_statLatencyNs.fetch_add(batched * wireNs - enqueuedNsSum, std::memory_order_relaxed);
+        uint64_t worst = wireNs - toNanoseconds(oldest);
+        if (worst > m_statMaxLatencyNs.load(std::memory_order_relaxed)) {
+            m_statMaxLatencyNs.store(worst, std::memory_order_relaxed);
+        }
+        for (size_t index = 0; index < COMMAND_PRIORITY_COUNT; ++index) {
+            const ClassBatch& classBatch = classBatches[index];
+            if (classBatch.commands == 0) {
+                continue;
+            }
+            m_statClassCommands[index].fetch_add(classBatch.commands, std::memory_order_relaxed);
+            m_statClassDelayNs[index].fetch_add(classBatch.commands * wireNs - classBatch.enqueuedNsSum,
+                std::memory_order_relaxed);
+            uint64_t classWorst = wireNs - toNanoseconds(classBatch.oldest);
+            if (classWorst > m_statClassMaxDelayNs[index].load(std::memory_order_relaxed)) {
+                m_statClassMaxDelayNs[index].store(classWorst, std::memory_order_relaxed);
+            }
+        }
+        if (!ok) {
+            m_statWriteErrors.fetch_add(1, std::memory_order_relaxed);
+        }
+        return true;
     }
 
     void SerialPort::listenerLoop() {
-        // Optimized read buffers
+        // Optimized read buffer
         std::vector<uint8_t> readBuffer(BUFFER_SIZE);
-        std::vector<uint8_t> lineBuffer(LINE_BUFFER_SIZE);
-        size_t linePos = 0;
 
-        auto lastCleanup = std::chrono::steady_clock::now();
-        constexpr auto cleanupInterval = std::chrono::milliseconds(50);
 
+#ifdef _WIN32
+        // Overlapped WaitCommEvent: the thread sleeps in the kernel until
+        // a byte arrives or close() signals m_listenerWake
+        OVERLAPPED readOverlapped{};
+        readOverlapped.hEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+        SetCommMask(m_handle, EV_RXCHAR);
+#endif
+
+#ifndef _WIN32
+        const std::function<void(const uint8_t*, size_t)> onRingRead = [this](const uint8_t* data, size_t length) {
+            processIncomingData(data, length);
+            };
+#endif
+
+        uint32_t realtimeSeen = 0;
         while (!m_stopListener && m_isOpen.load()) {
+            if (m_realtimeGeneration.load(std::memory_order_relaxed) != realtimeSeen) {
+                realtimeSeen = applyRealtime(ThreadRole::Listener);
+            }
+
             try {
+                // Expire timed-out commands; the wait below ends at the next
+                // deadline (rounded up to 1 ms) or blocks until data/wakeup
+                auto nextExpiry = expireTimedOutCommands();
+                int timeoutMs = -1;
+                if (nextExpiry != std::chrono::steady_clock::time_point::max()) {
+                    auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(
+                        nextExpiry - std::chrono::steady_clock::now()).count();
+                    timeoutMs = static_cast<int>(std::max<long long>((remaining + 999) / 1000, 0));
+                }
+
 #ifdef _WIN32
-                DWORD bytesAvailable = 0;
-                COMSTAT comStat;
-                DWORD errors;
+                DWORD eventMask = 0;
+                DWORD transferred = 0;
+                ResetEvent(readOverlapped.hEvent);
+                bumpCounter(m_statParks);
+
+                if (!WaitCommEvent(m_handle, &eventMask, &readOverlapped)) {
+                    if (GetLastError() != ERROR_IO_PENDING) {
+                        // A removed device also fails ClearCommError; anything
+                        // else is transient
+                        COMSTAT comStat;
+                        DWORD errors;
+                        if (!ClearCommError(m_handle, &errors, &comStat)) {
+                            handleConnectionLost();
+                            break;
+                        }
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                        continue;
+                    }
 
-                if (!ClearCommError(m_handle, &errors, &comStat)) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
-                    continue;
-                }
+                    // Bytes that arrived before the wait was armed raise no event
+                    COMSTAT comStat;
+                    DWORD errors;
+                    bool queued = ClearCommError(m_handle, &errors, &comStat) && comStat.cbInQue > 0;
 
-                bytesAvailable = comStat.cbInQue;
-                if (bytesAvailable == 0) {
-                    std::this_thread::sleep_for(std::chrono::microseconds(500));
-                    continue;
+                    DWORD waitResult = WAIT_OBJECT_0;
+                    if (!queued) {
+                        HANDLE waitHandles[2] = { readOverlapped.hEvent, m_listenerWake.handle() };
+                        waitResult = WaitForMultipleObjects(2, waitHandles, FALSE,
+                            timeoutMs < 0 ? INFINITE : static_cast<DWORD>(timeoutMs));
+                    }
+
+                    if (queued || waitResult != WAIT_OBJECT_0) {
+                        CancelIo(m_handle);
+                    }
+                    GetOverlappedResult(m_handle, &readOverlapped, &transferred, TRUE);
+                    if (!queued && waitResult != WAIT_OBJECT_0) {
+                        continue; // Wakeup or next timeout
+                    }
                 }
 
-                DWORD bytesToRead = std::min<DWORD>(bytesAvailable, static_cast<DWORD>(BUFFER_SIZE));
-                DWORD bytesRead = 0;
+                // Drain everything the driver has queued
+                while (true) {
+                    COMSTAT comStat;
+                    DWORD errors;
+                    if (!ClearCommError(m_handle, &errors, &comStat) || comStat.cbInQue == 0) {
+                        break;
+                    }
 
-                if (!ReadFile(m_handle, readBuffer.data(), bytesToRead, &bytesRead, nullptr)) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
-                    continue;
-                }
+                    DWORD bytesToRead = std::min<DWORD>(comStat.cbInQue, static_cast<DWORD>(BUFFER_SIZE));
+                    DWORD bytesRead = 0;
+                    ResetEvent(readOverlapped.hEvent);
+                    if (!ReadFile(m_handle, readBuffer.data(), bytesToRead, &bytesRead, &readOverlapped)) {
+                        if (GetLastError() != ERROR_IO_PENDING ||
+                            !GetOverlappedResult(m_handle, &readOverlapped, &bytesRead, TRUE)) {
+                            break;
+                        }
+                    }
 
-                // Process each byte efficiently
-                for (DWORD i = 0; i < bytesRead; ++i) {
-                    uint8_t byte = readBuffer[i];
+                    processIncomingData(readBuffer.data(), bytesRead);
+                }
 
-                    // Handle button data (non-printable characters < 32, except CR/LF)
-                    if (byte < 32 && byte != 0x0D && byte != 0x0A) {
-                        handleButtonData(byte);
+                // Spin window: keep polling the driver queue before arming
+                // the next wait; every hit restarts the window
+                int64_t spinNs = m_receiveSpinNs.load(std::memory_order_relaxed);
+                if (spinNs > 0) {
+                    auto spinStart = std::chrono::steady_clock::now();
+                    auto spinUntil = spinStart + std::chrono::nanoseconds(spinNs);
+                    auto now = spinStart;
+                    while (!m_stopListener) {
+                        COMSTAT comStat;
+                        DWORD errors;
+                        if (!ClearCommError(m_handle, &errors, &comStat)) {
+                            break;  // The next WaitCommEvent reports the failure
+                        }
+                        now = std::chrono::steady_clock::now();
+                        if (comStat.cbInQue > 0) {
+                            DWORD bytesToRead = std::min<DWORD>(comStat.cbInQue, static_cast<DWORD>(BUFFER_SIZE));
+                            DWORD bytesRead = 0;
+                            ResetEvent(readOverlapped.hEvent);
+                            if (!ReadFile(m_handle, readBuffer.data(), bytesToRead, &bytesRead, &readOverlapped) &&
+                                (GetLastError() != ERROR_IO_PENDING ||
+                                    !GetOverlappedResult(m_handle, &readOverlapped, &bytesRead, TRUE))) {
+                                break;
+                            }
+                            processIncomingData(readBuffer.data(), bytesRead);
+                            bumpCounter(m_statSpinHits);
+                            spinUntil = std::chrono::steady_clock::now() + std::chrono::nanoseconds(spinNs);
+                        }
+                        else if (now >= spinUntil) {
+                            bumpCounter(m_statSpinTimeouts);
+                            break;
+                        }
                     }
-                    else {
-                        // Handle text response data
-                        if (byte == 0x0A) { // Line feed
-                            if (linePos > 0) {
-                                std::string line(lineBuffer.begin(), lineBuffer.begin() + linePos);
-                                linePos = 0;
-                                if (!line.empty()) {
-                                    processResponse(line);
+                    bumpCounter(m_statSpinNs, toNanoseconds(now) - toNanoseconds(spinStart));
+                }
+#else
+                pollfd fds[2] = {
+                    { m_uring ? m_uring->fd() : m_fd, POLLIN, 0 },
+                    { m_listenerWake.fd(), POLLIN, 0 }
+                };
+
+                bumpCounter(m_statParks);
+                int ready = ::poll(fds, 2, timeoutMs);
+                if (ready <= 0) {
+                    continue; // Next timeout or EINTR
+                }
+
+                if (fds[1].revents & POLLIN) {
+                    m_listenerWake.drain();
+                }
+
+                // With VMIN = VTIME = 0 an empty queue reads as 0, not EAGAIN;
+                // a vanished device shows up as POLLHUP/POLLERR or EIO
+                bool lost = (fds[0].revents & (POLLERR | POLLHUP | POLLNVAL)) != 0;
+                if (m_uring) {
+                    // Ring completions: the spin window watches the CQ tail,
+                    // which costs no syscalls
+                    lost = lost || !m_uring->reap(onRingRead);
+                    int64_t spinNs = lost ? 0 : m_receiveSpinNs.load(std::memory_order_relaxed);
+                    if (spinNs > 0) {
+                        auto spinStart = std::chrono::steady_clock::now();
+                        auto spinUntil = spinStart + std::chrono::nanoseconds(spinNs);
+                        auto now = spinStart;
+                        while (!m_stopListener) {
+                            now = std::chrono::steady_clock::now();
+                            if (m_uring->hasCompletions()) {
+                                if (!m_uring->reap(onRingRead)) {
+                                    lost = true;
+                                    break;
                                 }
+                                bumpCounter(m_statSpinHits);
+                                spinUntil = std::chrono::steady_clock::now() + std::chrono::nanoseconds(spinNs);
                             }
-                        }
-                        else if (byte != 0x0D) { // Ignore carriage return
-                            if (linePos < LINE_BUFFER_SIZE - 1) {
-                                lineBuffer[linePos++] = byte;
+                            else if (now >= spinUntil) {
+                                bumpCounter(m_statSpinTimeouts);
+                                break;
                             }
                         }
+                        bumpCounter(m_statSpinNs, toNanoseconds(now) - toNanoseconds(spinStart));
                     }
                 }
-#endif
+                else if (fds[0].revents & POLLIN) {
+                    // Drain everything the tty has queued before blocking again
+                    while (true) {
+                        ssize_t bytesRead = ::read(m_fd, readBuffer.data(), readBuffer.size());
+                        if (bytesRead > 0) {
+                            processIncomingData(readBuffer.data(), static_cast<size_t>(bytesRead));
+                            if (static_cast<size_t>(bytesRead) < readBuffer.size()) {
+                                break;
+                            }
+                        }
+                        else if (bytesRead < 0 && errno == EINTR) {
+                            continue;
+                        }
+                        else {
+                            lost = lost || (bytesRead < 0 && errno != EAGAIN && errno != EWOULDBLOCK);
+                            break;
+                        }
+                    }
 
-                // Periodic cleanup of timed-out commands
-                auto now = std::chrono::steady_clock::now();
-                if (now - lastCleanup > cleanupInterval) {
-                    cleanupTimedOutCommands();
-                    lastCleanup = now;
+                    // Spin window: replies to pipelined commands usually land
+                    // within microseconds; every hit restarts the window
+                    int64_t spinNs = lost ? 0 : m_receiveSpinNs.load(std::memory_order_relaxed);
+                    if (spinNs > 0) {
+                        auto spinStart = std::chrono::steady_clock::now();
+                        auto spinUntil = spinStart + std::chrono::nanoseconds(spinNs);
+                        auto now = spinStart;
+                        while (!m_stopListener) {
+                            ssize_t bytesRead = ::read(m_fd, readBuffer.data(), readBuffer.size());
+                            now = std::chrono::steady_clock::now();
+                            if (bytesRead > 0) {
+                                processIncomingData(readBuffer.data(), static_cast<size_t>(bytesRead));
+                                bumpCounter(m_statSpinHits);
+                                spinUntil = std::chrono::steady_clock::now() + std::chrono::nanoseconds(spinNs);
+                            }
+                            else if (bytesRead < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                                lost = true;
+                                break;
+                            }
+                            else if (now >= spinUntil) {
+                                bumpCounter(m_statSpinTimeouts);
+                                break;
+                            }
+                        }
+                        bumpCounter(m_statSpinNs, toNanoseconds(now) - toNanoseconds(spinStart));
+                    }
                 }
 
+                if (lost) {
+                    handleConnectionLost();
+                    break;
+                }
+#endif
             }
             catch (const std::exception&) {
                 std::this_thread::sleep_for(std::chrono::milliseconds(1));
             }
         }
+
+#ifdef _WIN32
+        CloseHandle(readOverlapped.hEvent);
+#endif
+    }
+
+    // Streaming line splitter. Text runs are tracked as offsets into the
+    // receive buffer: a line that starts and ends inside this read is handed
+    // to processResponse as a view without copying; only a line split across
+    // reads (or interrupted by button bytes) is assembled in m_lineArena
+    void SerialPort::processIncomingData(const uint8_t* data, size_t length) {
+        if (m_lineArena.empty()) {
+            m_lineArena.resize(LINE_ARENA_INITIAL);
+            m_statArenaCapacity.store(m_lineArena.size(), std::memory_order_relaxed);
+        }
+
+        const char* text = reinterpret_cast<const char*>(data);
+        size_t runStart = 0;  // First byte of the text run not yet consumed
+
+        // Jump from control byte to control byte; button masks are still
+        // dispatched in arrival order
+        for (size_t i = findControlByte(data, 0, length); i < length; i = findControlByte(data, i + 1, length)) {
+            uint8_t byte = data[i];
+
+            bool lineEnd = byte == 0x0A || (byte == 0x0D && i + 1 < length && data[i + 1] == 0x0A);
+            if (lineEnd) {
+                std::string_view line;
+                bool assembled = m_linePos > 0 || m_lineOverflow;
+                if (!assembled) {
+                    line = std::string_view(text + runStart, i - runStart);
+                }
+                else {
+                    appendLine(text + runStart, i - runStart);
+                    line = std::string_view(m_lineArena.data(), m_linePos);
+                }
+                bool dropped = m_lineOverflow;
+                m_linePos = 0;
+                m_lineOverflow = false;
+                if (byte == 0x0D) {
+                    ++i;  // CRLF
+                }
+
+                // Listener is the only writer: plain stores, no locked RMW per line
+                if (dropped) {
+                    m_statLinesDropped.store(m_statLinesDropped.load(std::memory_order_relaxed) + 1,
+                        std::memory_order_relaxed);
+                }
+                else if (!line.empty()) {
+                    auto& counter = assembled ? m_statLinesAssembled : m_statLinesZeroCopy;
+                    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                    if (line.size() > m_statLongestLine.load(std::memory_order_relaxed)) {
+                        m_statLongestLine.store(line.size(), std::memory_order_relaxed);
+                    }
+                    processResponse(line);
+                }
+            }
+            else {
+                // Lone CR is dropped; other control bytes are button masks
+                appendLine(text + runStart, i - runStart);
+                if (byte != 0x0D) {
+                    handleButtonData(byte);
+                }
+            }
+            runStart = i + 1;
+        }
+
+        appendLine(text + runStart, length - runStart);
+    }
+
+    void SerialPort::feedReceived(const uint8_t* data, size_t length) {
+        if (m_isOpen) {
+            return;  // The listener owns the parser state
+        }
+        processIncomingData(data, length);
+    }
+
+    // Spill part of a line into the arena. A line past LINE_ARENA_LIMIT is
+    // dropped whole at its terminator rather than delivered truncated
+    void SerialPort::appendLine(const char* data, size_t length) {
+        if (length == 0 || m_lineOverflow) {
+            return;
+        }
+        size_t needed = m_linePos + length;
+        if (needed > LINE_ARENA_LIMIT) {
+            m_lineOverflow = true;
+            m_linePos = 0;
+            return;
+        }
+        if (needed > m_lineArena.size()) {
+            m_lineArena.resize(std::min(std::max(needed, m_lineArena.size() * 2), LINE_ARENA_LIMIT));
+            m_statArenaCapacity.store(m_lineArena.size(), std::memory_order_relaxed);
+        }
+        std::memcpy(m_lineArena.data() + m_linePos, data, length);
+        m_linePos = needed;
+    }
+
+    ReceiveStats SerialPort::getReceiveStats() const {
+        ReceiveStats stats;
+        stats.linesZeroCopy = m_statLinesZeroCopy.load(std::memory_order_relaxed);
+        stats.linesAssembled = m_statLinesAssembled.load(std::memory_order_relaxed);
+        stats.linesDropped = m_statLinesDropped.load(std::memory_order_relaxed);
+        stats.longestLine = m_statLongestLine.load(std::memory_order_relaxed);
+        stats.arenaCapacity = m_statArenaCapacity.load(std::memory_order_relaxed);
+        stats.spinHits = m_statSpinHits.load(std::memory_order_relaxed);
+        stats.spinTimeouts = m_statSpinTimeouts.load(std::memory_order_relaxed);
+        stats.parks = m_statParks.load(std::memory_order_relaxed);
+        stats.spinNs = m_statSpinNs.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void SerialPort::setReceiveSpinTime(std::chrono::microseconds spin) {
+        m_receiveSpinNs = std::max<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(spin).count(), 0);
+    }
+
+    std::chrono::microseconds SerialPort::getReceiveSpinTime() const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::nanoseconds(m_receiveSpinNs.load()));
     }
 
     void SerialPort::handleButtonData(uint8_t data) {
@@ -304,84 +2823,99 @@ namespace makcu {
         }
     }
 
-    void SerialPort::processResponse(const std::string& response) {
-        // Remove ">>> " prefix if present
-        std::string content = response;
-        if (content.substr(0, 4) == ">>> ") {
-            content = content.substr(4);
+    // Parses in place: optional ">>> " prompt, then "<text>#<id>:<payload>"
+    // for correlated replies; anything else resolves the oldest in-flight
+    // command. Strings are only materialized when a result is handed over
+    void SerialPort::processResponse(std::string_view response) {
+        constexpr std::string_view PROMPT = ">>> ";
+        if (response.substr(0, PROMPT.size()) == PROMPT) {
+            response.remove_prefix(PROMPT.size());
         }
 
-        // Check for command ID correlation
-        size_t hashPos = content.find('#');
-        if (hashPos != std::string::npos) {
-            // Extract command ID
-            std::string idStr = content.substr(hashPos + 1);
-            size_t colonPos = idStr.find(':');
-            if (colonPos != std::string::npos) {
-                try {
-                    int cmdId = std::stoi(idStr.substr(0, colonPos));
-                    std::string result = idStr.substr(colonPos + 1);
-
+        // Command ID correlation
+        size_t hashPos = response.find('#');
+        if (hashPos != std::string_view::npos) {
+            size_t colonPos = response.find(':', hashPos + 1);
+            if (colonPos != std::string_view::npos) {
+                const char* first = response.data() + hashPos + 1;
+                const char* last = response.data() + colonPos;
+                int cmdId = 0;
+                auto [end, ec] = std::from_chars(first, last, cmdId);
+                if (ec == std::errc() && end == last) {
+                    // Stale ids (slot since reused) fail the generation check
                     std::lock_guard<std::mutex> lock(m_commandMutex);
-                    auto it = m_pendingCommands.find(cmdId);
-                    if (it != m_pendingCommands.end()) {
-                        try {
-                            it->second->promise.set_value(result);
-                        }
-                        catch (...) {
-                            // Promise already set
-                        }
-                        m_pendingCommands.erase(it);
+                    if (PendingCommand* pending = m_pendingCommands.find(cmdId)) {
+                        completeCommand(*pending, response.substr(colonPos + 1));
                     }
                     return;
                 }
-                catch (...) {
-                    // Failed to parse ID, treat as normal response
-                }
+                // Not an id, treat as normal response
             }
         }
 
         // Handle untracked response (oldest pending command)
         std::lock_guard<std::mutex> lock(m_commandMutex);
-        if (!m_pendingCommands.empty()) {
-            auto it = m_pendingCommands.begin();
-            try {
-                it->second->promise.set_value(content);
-            }
-            catch (...) {
-                // Promise already set
+        if (PendingCommand* pending = m_pendingCommands.oldest()) {
+            if (!pending->untagged_match.empty() && response.find(pending->untagged_match) == std::string_view::npos) {
+                return;
             }
-            m_pendingCommands.erase(it);
+            completeCommand(*pending, response);
         }
     }
 
-    void SerialPort::cleanupTimedOutCommands() {
+    // Fails every promise-backed command past its deadline and returns the
+    // next deadline, which becomes the listener's wait timeout
+    std::chrono::steady_clock::time_point SerialPort::expireTimedOutCommands() {
         auto now = std::chrono::steady_clock::now();
 
         std::lock_guard<std::mutex> lock(m_commandMutex);
-        auto it = m_pendingCommands.begin();
-        while (it != m_pendingCommands.end()) {
-            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-                now - it->second->timestamp);
+        while (PendingCommand* cmd = m_pendingCommands.popExpired(now)) {
+            failCommand(*cmd, "Command timeout");
+        }
+        m_listenerDeadline = m_pendingCommands.nextDeadline();
+        return m_listenerDeadline;
+    }
 
-            if (elapsed > it->second->timeout) {
-                try {
-                    it->second->promise.set_exception(std::make_exception_ptr(
-                        std::runtime_error("Command timeout")));
-                }
-                catch (...) {
-                    // Promise already set
-                }
-                it = m_pendingCommands.erase(it);
+    // Completion, called under m_commandMutex. Promise-backed slots are
+    // released here; query() slots are handed back to the waiter, which
+    // releases them after taking the result
+    void SerialPort::completeCommand(PendingCommand& command, std::string_view result) {
+        if (command.has_promise) {
+            try {
+                command.promise->set_value(std::string(result));
             }
-            else {
-                ++it;
+            catch (...) {
+                // Promise already set
             }
+            m_pendingCommands.release(command);
+            return;
+        }
+
+        command.result.assign(result);
+        {
+            std::lock_guard<std::mutex> lock(command.mutex);
+            command.status.store(PendingCommand::Ready, std::memory_order_release);
         }
+        command.done.notify_one();
     }
 
-    int SerialPort::generateCommandId() {
-        return (m_commandCounter.fetch_add(1) % 10000) + 1;
+    void SerialPort::failCommand(PendingCommand& command, const char* reason) {
+        if (command.has_promise) {
+            try {
+                command.promise->set_exception(std::make_exception_ptr(std::runtime_error(reason)));
+            }
+            catch (...) {
+                // Promise already set
+            }
+            m_pendingCommands.release(command);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(command.mutex);
+            command.status.store(PendingCommand::Failed, std::memory_order_release);
+        }
+        command.done.notify_one();
     }
 
     bool SerialPort::configurePort() {
@@ -417,7 +2951,53 @@ namespace makcu {
         updateTimeouts();
         return true;
 #else
-        return false;
+        termios tty{};
+        if (tcgetattr(m_fd, &tty) != 0) {
+            return false;
+        }
+
+        // Raw 8N1, no flow control, reads return whatever is queued
+        cfmakeraw(&tty);
+        tty.c_cflag |= (CLOCAL | CREAD);
+        tty.c_cflag &= ~(CSTOPB | PARENB | HUPCL);
+#ifdef CRTSCTS
+        tty.c_cflag &= ~CRTSCTS;
+#endif
+        tty.c_iflag &= ~(IXON | IXOFF | IXANY);
+        tty.c_cc[VMIN] = 0;
+        tty.c_cc[VTIME] = 0;
+
+        speed_t speed = toTermiosSpeed(m_baudRate);
+        if (speed != 0) {
+            cfsetispeed(&tty, speed);
+            cfsetospeed(&tty, speed);
+        }
+
+        if (tcsetattr(m_fd, TCSANOW, &tty) != 0) {
+            return false;
+        }
+
+        if (speed == 0 && !setCustomBaudRate(m_fd, m_baudRate)) {
+            return false;
+        }
+
+        // Match the Windows DTR/RTS_CONTROL_DISABLE setup (not supported on ptys)
+        int modemBits = TIOCM_DTR | TIOCM_RTS;
+        ioctl(m_fd, TIOCMBIC, &modemBits);
+
+        // Best effort: a refused flag shows up in getRealtimeStatus()
+        {
+            std::lock_guard<std::mutex> rtLock(m_realtimeMutex);
+            if (m_realtime.enabled && m_realtime.lowLatencyTty) {
+                setLowLatency(true);
+            }
+            else {
+                m_rtLowLatency.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        tcflush(m_fd, TCIOFLUSH);
+        return true;
 #endif
     }
 
@@ -434,10 +3014,186 @@ namespace makcu {
 #endif
     }
 
+    bool SerialPort::setIoBackend(IoBackend backend, bool sqPoll) {
+        if (backend == IoBackend::IO_URING && !IoUring::available()) {
+            return false;
+        }
+        m_ioBackend = backend;
+        m_uringSqPoll = sqPoll;
+        return true;
+    }
+
+    IoBackend SerialPort::getIoBackend() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_isOpen) {
+            return m_uring ? IoBackend::IO_URING : IoBackend::POLL;
+        }
+        return m_ioBackend.load();
+    }
+
+    bool SerialPort::isSqPolling() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_isOpen && m_uring && m_uring->sqPolling();
+    }
+
+    // The armed read must park in the kernel rather than complete empty, so
+    // the fd switches to blocking reads with VMIN = 1. Caller holds m_mutex
+    bool SerialPort::startIoUring() {
+#ifdef MAKCU_IO_URING
+        auto ring = std::make_unique<IoUring>();
+        if (!ring->create(m_fd, BUFFER_SIZE, m_uringSqPoll.load())) {
+            return false;
+        }
+
+        termios tty{};
+        int flags = fcntl(m_fd, F_GETFL);
+        if (flags < 0 || tcgetattr(m_fd, &tty) != 0) {
+            return false;
+        }
+        termios blocking = tty;
+        blocking.c_cc[VMIN] = 1;
+        if (tcsetattr(m_fd, TCSANOW, &blocking) != 0 ||
+            fcntl(m_fd, F_SETFL, flags & ~O_NONBLOCK) != 0 ||
+            !ring->armRead()) {
+            ring.reset();
+            tcsetattr(m_fd, TCSANOW, &tty);
+            fcntl(m_fd, F_SETFL, flags);
+            return false;
+        }
+
+        m_uring = std::move(ring);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool SerialPort::setRealtimeMode(const RealtimeConfig& config) {
+        bool ok = true;
+        {
+            std::lock_guard<std::mutex> rtLock(m_realtimeMutex);
+            m_realtime = config;
+
+            // Assume granted; any thread the OS refuses clears the flag
+            m_rtAffinity.store(config.enabled && (config.listenerCpu >= 0 || config.writerCpu >= 0));
+            m_rtPriority.store(config.enabled && config.priority > 0);
+
+            bool lockMemory = config.enabled && config.lockMemory;
+            if (lockMemory != m_rtMemoryLocked.load()) {
+                bool done = lockProcessMemory(lockMemory);
+                m_rtMemoryLocked.store(lockMemory && done);
+                ok = ok && (done || !lockMemory);
+            }
+            m_realtimeGeneration.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // The listener adopts the mode right away; writer and scheduler at
+        // their next wakeup
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_isOpen) {
+            std::lock_guard<std::mutex> rtLock(m_realtimeMutex);
+            bool lowLatency = config.enabled && config.lowLatencyTty;
+            if (lowLatency || m_rtLowLatency.load()) {
+                ok = setLowLatency(lowLatency) && ok;
+            }
+            m_listenerWake.signal();
+        }
+        return ok;
+    }
+
+    RealtimeConfig SerialPort::getRealtimeMode() const {
+        std::lock_guard<std::mutex> lock(m_realtimeMutex);
+        return m_realtime;
+    }
+
+    RealtimeStatus SerialPort::getRealtimeStatus() const {
+        RealtimeStatus status;
+        status.affinity = m_rtAffinity.load();
+        status.priority = m_rtPriority.load();
+        status.memoryLocked = m_rtMemoryLocked.load();
+        status.lowLatencyTty = m_rtLowLatency.load();
+        return status;
+    }
+
+    // Called by each internal thread on itself when the configuration
+    // generation changes; returns the generation applied
+    uint32_t SerialPort::applyRealtime(ThreadRole role) {
+        RealtimeConfig config;
+        uint32_t generation;
+        {
+            std::lock_guard<std::mutex> lock(m_realtimeMutex);
+            config = m_realtime;
+            generation = m_realtimeGeneration.load(std::memory_order_relaxed);
+        }
+
+        if (!config.enabled) {
+            pinCurrentThread(-1);
+            setCurrentThreadPriority(0);
+            return generation;
+        }
+
+        if (config.lockMemory) {
+            prefaultStack();
+            if (role == ThreadRole::Listener && m_lineArena.size() < LINE_ARENA_LIMIT) {
+                // Full-size arena up front: no growth (allocation) mid-stream
+                m_lineArena.resize(LINE_ARENA_LIMIT);
+                m_statArenaCapacity.store(m_lineArena.size(), std::memory_order_relaxed);
+            }
+        }
+
+        int cpu = role == ThreadRole::Listener ? config.listenerCpu : config.writerCpu;
+        if (cpu >= 0 && !pinCurrentThread(cpu)) {
+            m_rtAffinity.store(false);
+        }
+        if (config.priority > 0 && !setCurrentThreadPriority(config.priority)) {
+            m_rtPriority.store(false);
+        }
+        return generation;
+    }
+
+    // ASYNC_LOW_LATENCY: the driver pushes received bytes to the tty layer
+    // immediately instead of batching them. Caller holds m_realtimeMutex
+    bool SerialPort::setLowLatency(bool enable) {
+        bool ok = false;
+#ifdef __linux__
+        serial_struct serial{};
+        if (ioctl(m_fd, TIOCGSERIAL, &serial) == 0) {
+            if (enable) {
+                serial.flags |= ASYNC_LOW_LATENCY;
+            }
+            else {
+                serial.flags &= ~ASYNC_LOW_LATENCY;
+            }
+            ok = ioctl(m_fd, TIOCSSERIAL, &serial) == 0;
+        }
+#endif
+        m_rtLowLatency.store(enable && ok);
+        return ok;
+    }
+
     void SerialPort::setButtonCallback(ButtonCallback callback) {
         m_buttonCallback = callback;
     }
 
+    void SerialPort::setDisconnectCallback(DisconnectCallback callback) {
+        m_disconnectCallback = callback;
+    }
+
+    // Called from the listener right before it exits. The handle stays open
+    // so writes fail fast until the owner calls close()
+    void SerialPort::handleConnectionLost() {
+        if (m_stopListener || !m_isOpen.load()) {
+            return;  // Our own close(), not a device failure
+        }
+        if (m_disconnectCallback) {
+            try {
+                m_disconnectCallback();
+            }
+            catch (...) {
+            }
+        }
+    }
+
     // Legacy compatibility methods
     bool SerialPort::setBaudRate(uint32_t baudRate) {
         std::lock_guard<std::mutex> lock(m_mutex);
@@ -450,7 +3206,7 @@ namespace makcu {
         m_dcb.BaudRate = baudRate;
         return SetCommState(m_handle, &m_dcb) != 0;
 #else
-        return false;
+        return configurePort();
 #endif
     }
 
@@ -479,15 +3235,28 @@ namespace makcu {
 
 #ifdef _WIN32
         buffer.resize(maxBytes);
+        OVERLAPPED overlapped{};
+        overlapped.hEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
         DWORD bytesRead = 0;
         bool result = ReadFile(m_handle, buffer.data(),
-            static_cast<DWORD>(maxBytes), &bytesRead, nullptr);
+            static_cast<DWORD>(maxBytes), &bytesRead, &overlapped) != 0;
+        if (!result && GetLastError() == ERROR_IO_PENDING) {
+            result = GetOverlappedResult(m_handle, &overlapped, &bytesRead, TRUE) != 0;
+        }
+        CloseHandle(overlapped.hEvent);
         if (result && bytesRead > 0) {
             buffer.resize(bytesRead);
         }
         else {
             buffer.clear();
         }
+#else
+        if (m_uring) {
+            return buffer;  // The armed ring read owns the input
+        }
+        buffer.resize(maxBytes);
+        ssize_t bytesRead = ::read(m_fd, buffer.data(), maxBytes);
+        buffer.resize(bytesRead > 0 ? static_cast<size_t>(bytesRead) : 0);
 #endif
 
         return buffer;
@@ -510,6 +3279,11 @@ namespace makcu {
         if (ClearCommError(m_handle, &errors, &comStat)) {
             return comStat.cbInQue;
         }
+#else
+        int queued = 0;
+        if (ioctl(m_fd, FIONREAD, &queued) == 0 && queued > 0) {
+            return static_cast<size_t>(queued);
+        }
 #endif
 
         return 0;
@@ -524,7 +3298,10 @@ namespace makcu {
 #ifdef _WIN32
         return FlushFileBuffers(m_handle) != 0;
 #else
-        return false;
+        if (m_uring && !m_uring->waitWritesIdle(std::chrono::milliseconds(m_timeout))) {
+            return false;
+        }
+        return tcdrain(m_fd) == 0;
 #endif
     }
 
@@ -570,13 +3347,76 @@ namespace makcu {
 
             RegCloseKey(hKey);
         }
+#elif defined(__linux__)
+        ports = listSysfsTtys("/sys", false);
 #endif
 
         std::sort(ports.begin(), ports.end());
         return ports;
     }
 
+    namespace {
+
+        struct PortCache {
+            std::mutex mutex;
+            std::vector<std::string> ports;
+            bool valid = false;
+#ifdef __linux__
+            int inotifyFd = -2;  // -2: not set up yet, -1: unavailable (never cache)
+            std::string sysfsRoot = "/sys";
+            std::string watchDir = "/dev";
+#else
+            std::chrono::steady_clock::time_point scannedAt;
+#endif
+        };
+
+#ifndef __linux__
+        // Without a hotplug watch a hit is only trusted this long, so an
+        // unplugged or re-enumerated device is noticed on a later call
+        constexpr auto PORT_CACHE_TTL = std::chrono::seconds(1);
+#endif
+
+        PortCache& portCache() {
+            static PortCache cache;
+            return cache;
+        }
+
+    } // namespace
+
     std::vector<std::string> SerialPort::findMakcuPorts() {
+        PortCache& cache = portCache();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+
+#ifdef __linux__
+        if (cache.inotifyFd == -2) {
+            cache.inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if (cache.inotifyFd >= 0 &&
+                inotify_add_watch(cache.inotifyFd, cache.watchDir.c_str(), IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO) < 0) {
+                ::close(cache.inotifyFd);
+                cache.inotifyFd = -1;
+            }
+        }
+        if (cache.inotifyFd < 0) {
+            cache.valid = false;
+        }
+        else {
+            // Any hotplug in watchDir since the last scan invalidates the result
+            alignas(inotify_event) char events[4096];
+            while (::read(cache.inotifyFd, events, sizeof(events)) > 0) {
+                cache.valid = false;
+            }
+        }
+
+        if (!cache.valid) {
+            cache.ports = findMakcuPorts(cache.sysfsRoot);
+            cache.valid = cache.inotifyFd >= 0;
+        }
+        return cache.ports;
+#else
+        auto now = std::chrono::steady_clock::now();
+        if (cache.valid && now - cache.scannedAt < PORT_CACHE_TTL) {
+            return cache.ports;
+        }
         std::vector<std::string> makcuPorts;
 
 #ifdef _WIN32
@@ -628,7 +3468,47 @@ namespace makcu {
 
         std::sort(makcuPorts.begin(), makcuPorts.end());
         makcuPorts.erase(std::unique(makcuPorts.begin(), makcuPorts.end()), makcuPorts.end());
+        // Only a hit is kept, so a device plugged in later is still found on
+        // the next call; PORT_CACHE_TTL bounds how long a hit can go stale
+        cache.ports = makcuPorts;
+        cache.valid = !makcuPorts.empty();
+        cache.scannedAt = now;
         return makcuPorts;
+#endif
+    }
+
+    void SerialPort::invalidatePortCache() {
+        PortCache& cache = portCache();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        cache.valid = false;
+    }
+
+    void SerialPort::setPortDiscoveryRoots(const std::string& sysfsRoot, const std::string& watchDir) {
+        PortCache& cache = portCache();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        cache.valid = false;
+#ifdef __linux__
+        if (cache.inotifyFd >= 0) {
+            ::close(cache.inotifyFd);
+        }
+        cache.inotifyFd = -2;  // Watch the new directory on the next scan
+        cache.sysfsRoot = sysfsRoot;
+        cache.watchDir = watchDir;
+#else
+        (void)sysfsRoot;
+        (void)watchDir;
+#endif
+    }
+
+    std::vector<std::string> SerialPort::findMakcuPorts(const std::string& sysfsRoot) {
+        std::vector<std::string> ports;
+#ifdef __linux__
+        ports = listSysfsTtys(sysfsRoot, true);
+#else
+        (void)sysfsRoot;
+#endif
+        std::sort(ports.begin(), ports.end());
+        return ports;
     }
 
 } // namespace makcu
\ No newline at end of file
@@ -0,0 +1,45 @@
+#!/bin/bash
+# Build and run the MAKCU tests (Linux)
+# Usage: tests/run_tests.sh
+
+TEST_DIR="$(cd "$(dirname "$0")" && pwd)"
+ROOT_DIR="$(dirname "$TEST_DIR")"
+OUT_DIR="$TEST_DIR/bin"
+
+if [[ "$OSTYPE" != "linux-gnu"* ]]; then
+    echo "❌ Error: The tests use a fake sysfs tree and need Linux"
+    exit 1
+fi
+
+if command -v g++ &> /dev/null; then
+    COMPILER="g++"
+elif command -v clang++ &> /dev/null; then
+    COMPILER="clang++"
+else
+    echo "❌ Error: No C++ compiler found (g++ or clang++)"
+    exit 1
+fi
+
+FLAGS="-std=c++17 -O2 -Wall -Wextra -I$ROOT_DIR/include"
+LIBRARY="$ROOT_DIR/src/makcu.cpp $ROOT_DIR/src/serialport.cpp"
+
+mkdir -p "$OUT_DIR"
+FAILED=0
+
+for source in "$TEST_DIR"/test_*.cpp; do
+    name="$(basename "$source" .cpp)"
+    echo "Building $name..."
+    if ! $COMPILER $FLAGS "$source" $LIBRARY -o "$OUT_DIR/$name" -pthread; then
+        echo "❌ Error: $name failed to build"
+        exit 1
+    fi
+    if ! "$OUT_DIR/$name"; then
+        FAILED=1
+    fi
+done
+
+if [ $FAILED -ne 0 ]; then
+    echo "❌ Tests failed"
+    exit 1
+fi
+echo "✅ All tests passed"
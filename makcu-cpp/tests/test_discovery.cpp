@@ -0,0 +1,128 @@
+// Linux port discovery against a fake sysfs tree: VID/PID and product
+// matching, and the inotify-driven cache in findMakcuPorts().
+//
+// Build and run: tests/run_tests.sh
+
+#include "../include/serialport.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+    int failures = 0;
+
+    void check(bool condition, const std::string& what) {
+        std::cout << (condition ? "  ok    " : "  FAIL  ") << what << "\n";
+        if (!condition) {
+            ++failures;
+        }
+    }
+
+    std::string describe(const std::vector<std::string>& ports) {
+        std::string text = "{";
+        for (const auto& port : ports) {
+            text += (text.size() > 1 ? ", " : "") + port;
+        }
+        return text + "}";
+    }
+
+    void makeDirs(const std::string& path) {
+        for (size_t pos = 1; pos != std::string::npos;) {
+            pos = path.find('/', pos + 1);
+            mkdir(path.substr(0, pos).c_str(), 0755);
+        }
+    }
+
+    void writeFile(const std::string& path, const std::string& contents) {
+        std::ofstream(path) << contents << "\n";
+    }
+
+    // <sys>/devices/usb1/<port> with idVendor/idProduct/product, and a tty
+    // under the interface (cdc_acm) or one level below it (usb-serial)
+    void addUsbTty(const std::string& sys, const std::string& tty, const std::string& port,
+        const std::string& vid, const std::string& pid, const std::string& product, bool usbSerial) {
+        std::string usbDevice = sys + "/devices/usb1/" + port;
+        std::string device = usbDevice + "/" + port + ":1.0" + (usbSerial ? "/" + tty : "");
+        makeDirs(device);
+        writeFile(usbDevice + "/idVendor", vid);
+        writeFile(usbDevice + "/idProduct", pid);
+        writeFile(usbDevice + "/product", product);
+
+        std::string classDir = sys + "/class/tty/" + tty;
+        makeDirs(classDir);
+        symlink(device.c_str(), (classDir + "/device").c_str());
+    }
+
+    void addVirtualTty(const std::string& sys, const std::string& tty) {
+        makeDirs(sys + "/class/tty/" + tty);  // No device link
+    }
+
+    void touch(const std::string& path) {
+        writeFile(path, "");
+    }
+
+}
+
+int main() {
+    char scratch[] = "/tmp/makcu_discovery_XXXXXX";
+    if (!mkdtemp(scratch)) {
+        std::cerr << "mkdtemp failed\n";
+        return 1;
+    }
+    const std::string root = scratch;
+    const std::string sys = root + "/sys";
+    const std::string dev = root + "/dev";
+    makeDirs(dev);
+
+    std::cout << "=== PORT DISCOVERY ===\n";
+
+    addUsbTty(sys, "ttyACM0", "1-1", "1a86", "55d3", "USB Single Serial", false);  // MAKCU VID/PID
+    addUsbTty(sys, "ttyUSB0", "1-2", "1a86", "7523", "USB-SERIAL CH340", true);    // Matched by product
+    addUsbTty(sys, "ttyUSB1", "1-3", "0403", "6001", "FT232R USB UART", true);     // Other vendor
+    addVirtualTty(sys, "tty0");
+
+    std::vector<std::string> expected = { "/dev/ttyACM0", "/dev/ttyUSB0" };
+    std::vector<std::string> found = makcu::SerialPort::findMakcuPorts(sys);
+    check(found == expected, "uncached scan matches VID/PID and product: " + describe(found));
+
+    // Cached scan over the fake tree; dev stands in for /dev
+    makcu::SerialPort::setPortDiscoveryRoots(sys, dev);
+    found = makcu::SerialPort::findMakcuPorts();
+    check(found == expected, "first cached scan: " + describe(found));
+
+    addUsbTty(sys, "ttyACM1", "1-4", "1a86", "55d3", "USB Single Serial", false);
+    found = makcu::SerialPort::findMakcuPorts();
+    check(found == expected, "no hotplug event: cached result kept");
+
+    touch(dev + "/ttyACM1");
+    found = makcu::SerialPort::findMakcuPorts();
+    expected = { "/dev/ttyACM0", "/dev/ttyACM1", "/dev/ttyUSB0" };
+    check(found == expected, "node created in dev: rescanned " + describe(found));
+
+    unlink((sys + "/class/tty/ttyACM0/device").c_str());
+    found = makcu::SerialPort::findMakcuPorts();
+    check(found == expected, "sysfs change alone: cached result kept");
+
+    unlink((dev + "/ttyACM1").c_str());
+    found = makcu::SerialPort::findMakcuPorts();
+    expected = { "/dev/ttyACM1", "/dev/ttyUSB0" };
+    check(found == expected, "node removed from dev: rescanned " + describe(found));
+
+    unlink((sys + "/class/tty/ttyACM1/device").c_str());
+    makcu::SerialPort::invalidatePortCache();
+    found = makcu::SerialPort::findMakcuPorts();
+    expected = { "/dev/ttyUSB0" };
+    check(found == expected, "invalidatePortCache() forces a rescan: " + describe(found));
+
+    makcu::SerialPort::setPortDiscoveryRoots("/sys", "/dev");
+    std::system(("rm -rf " + root).c_str());
+
+    std::cout << (failures == 0 ? "All discovery checks passed\n" : "Discovery checks FAILED\n");
+    return failures == 0 ? 0 : 1;
+}